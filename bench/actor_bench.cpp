@@ -0,0 +1,85 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "ccl/actor.h"
+#include "ccl/countdown_latch.h"
+#include "ccl/typed_actor.h"
+#include "bench.h"
+
+using ccl::any;
+using ccl::any_cast;
+
+// Sends a message and waits for the reply each time.
+CCL_BENCHMARK(Actor_Send_RoundTrip, 50000) {
+    uint64_t n = state.Iterations();
+    std::vector<int64_t> latencies(n);
+    ccl::Actor actor([](any& msg) { return msg; });
+
+    state.Start();
+    for (uint64_t i = 0; i < n; i++) {
+        int64_t sent = bench::Now();
+        actor.Send(any(static_cast<int64_t>(i))).get();
+        latencies[i] = bench::Now() - sent;
+    }
+    state.Stop();
+
+    state.AddLatencies(latencies);
+}
+
+// Tells timestamps without waiting and records the time until each one is received.
+CCL_BENCHMARK(Actor_Tell_Throughput, 200000) {
+    uint64_t n = state.Iterations();
+    std::vector<int64_t> latencies(n);
+    uint64_t received = 0; // only touched by the actor
+    ccl::CountdownLatch latch;
+    ccl::Actor actor([&](any& msg) {
+        latencies[received] = bench::Now() - any_cast<int64_t>(msg);
+        if (++received == latencies.size()) {
+            latch.CountDown();
+        }
+        return any();
+    });
+
+    state.Start();
+    for (uint64_t i = 0; i < n; i++) {
+        actor.Tell(any(bench::Now()));
+    }
+    latch.Await();
+    state.Stop();
+
+    state.AddLatencies(latencies);
+}
+
+// Tells timestamps with at most 256 of them pending, so the mailbox is
+// drained as fast as it is filled, as in a steady state.
+CCL_BENCHMARK(TypedActor_Tell_Window, 200000) {
+    const uint64_t window = 256;
+    struct Receiver {
+        std::vector<int64_t>* latencies;
+        std::atomic<uint64_t>* received;
+
+        void operator()(int64_t& sent) {
+            uint64_t i = received->load(std::memory_order_relaxed);
+            (*latencies)[i] = bench::Now() - sent;
+            received->store(i + 1, std::memory_order_release);
+        }
+    };
+    uint64_t n = state.Iterations();
+    std::vector<int64_t> latencies(n);
+    std::atomic<uint64_t> received(0);
+    ccl::TypedActor<int64_t> actor(Receiver{&latencies, &received});
+
+    state.Start();
+    for (uint64_t i = 0; i < n; i++) {
+        while (i >= window && received.load(std::memory_order_acquire) <= i - window) {
+            std::this_thread::yield();
+        }
+        actor.Tell(bench::Now());
+    }
+    while (received.load(std::memory_order_acquire) < n) {
+        std::this_thread::yield();
+    }
+    state.Stop();
+
+    state.AddLatencies(latencies);
+}
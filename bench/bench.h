@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+// A minimal benchmark harness in the style of Google Benchmark.
+// A benchmark is registered with
+//
+//     CCL_BENCHMARK(BlockingQueue_PushPop, 100000) {
+//         ... setup ...
+//         state.Start();
+//         ... run state.Iterations() operations ...
+//         state.Stop();
+//         state.AddLatencies(latencies);
+//     }
+//
+// and ccl_bench runs it, reporting ops/sec, latency percentiles and heap
+// allocations per operation between Start and Stop.
+namespace bench {
+
+// Returns the steady clock in nanoseconds, for latency samples.
+inline int64_t Now() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Returns the number of operator new calls so far in the process.
+uint64_t AllocationCount();
+
+class State final {
+private:
+    const uint64_t m_iterations;
+    uint64_t m_ops;
+    int64_t m_startTime; // [ns]
+    int64_t m_elapsed; // [ns]
+    uint64_t m_startAllocations;
+    uint64_t m_allocations;
+    std::vector<int64_t> m_latencies; // [ns]
+
+public:
+    explicit State(uint64_t iterations)
+            : m_iterations(iterations), m_ops(iterations), m_startTime(0), m_elapsed(0)
+            , m_startAllocations(0), m_allocations(0) {}
+
+    ~State() = default;
+    State(const State&) = delete;
+    State& operator=(const State&) = delete;
+
+    // The number of operations the benchmark should run.
+    uint64_t Iterations() const {
+        return m_iterations;
+    }
+
+    // Starts the clock and the allocation counter. Setup before it is not measured.
+    void Start() {
+        m_startAllocations = AllocationCount();
+        m_startTime = Now();
+    }
+
+    void Stop() {
+        m_elapsed = Now() - m_startTime;
+        m_allocations = AllocationCount() - m_startAllocations;
+    }
+
+    // Overrides the number of operations if the benchmark ran other than Iterations().
+    void SetOps(uint64_t ops) {
+        m_ops = ops;
+    }
+
+    // Adds latency samples [ns]. Not thread-safe: threads collect their
+    // samples on their own and add them after Stop.
+    void AddLatencies(const std::vector<int64_t>& latencies) {
+        m_latencies.insert(m_latencies.end(), latencies.begin(), latencies.end());
+    }
+
+    uint64_t Ops() const { return m_ops; }
+    int64_t Elapsed() const { return m_elapsed; }
+    uint64_t Allocations() const { return m_allocations; }
+    std::vector<int64_t>& Latencies() { return m_latencies; }
+};
+
+struct Benchmark {
+    const char* name;
+    void (*function)(State&);
+    uint64_t iterations;
+};
+
+inline std::vector<Benchmark>& Registry() {
+    static std::vector<Benchmark> registry;
+    return registry;
+}
+
+inline int Register(const char* name, void (*function)(State&), uint64_t iterations) {
+    Registry().push_back(Benchmark{name, function, iterations});
+    return 0;
+}
+
+} // namespace bench
+
+#define CCL_BENCHMARK(name, iterations) \
+    static void name(::bench::State& state); \
+    static int name##_registered = ::bench::Register(#name, name, iterations); \
+    static void name(::bench::State& state)
@@ -0,0 +1,213 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.h"
+
+// Counts heap allocations of the whole process.
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size != 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace bench {
+
+uint64_t AllocationCount() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+} // namespace bench
+
+namespace {
+
+struct options {
+    std::string filter;
+    std::string format; // console or json
+    std::string out; // a file to write the JSON report to
+    int repetitions;
+    double scale; // multiplies the iterations of every benchmark
+};
+
+struct result {
+    std::string name;
+    uint64_t ops;
+    double opsPerSec; // the median of the repetitions
+    double allocsPerOp;
+    int64_t p50, p99, p999; // [ns]
+};
+
+// Nearest-rank percentile of sorted samples.
+int64_t percentile(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(p * sorted.size());
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+result run(const bench::Benchmark& b, const options& opts) {
+    uint64_t iterations = std::max<uint64_t>(1, static_cast<uint64_t>(b.iterations * opts.scale));
+    { // warm up the caches, the allocator and the thread stacks
+        bench::State state(iterations);
+        b.function(state);
+    }
+    std::vector<double> opsPerSec;
+    std::vector<int64_t> latencies;
+    uint64_t ops = 0;
+    uint64_t allocations = 0;
+    for (int i = 0; i < opts.repetitions; i++) {
+        bench::State state(iterations);
+        b.function(state);
+        opsPerSec.push_back(state.Ops() * 1e9 / std::max<int64_t>(1, state.Elapsed()));
+        ops += state.Ops();
+        allocations += state.Allocations();
+        latencies.insert(latencies.end(), state.Latencies().begin(), state.Latencies().end());
+    }
+    std::sort(opsPerSec.begin(), opsPerSec.end());
+    std::sort(latencies.begin(), latencies.end());
+    result r;
+    r.name = b.name;
+    r.ops = ops / opts.repetitions;
+    r.opsPerSec = opsPerSec[opsPerSec.size() / 2];
+    r.allocsPerOp = ops != 0 ? static_cast<double>(allocations) / ops : 0;
+    r.p50 = percentile(latencies, 0.50);
+    r.p99 = percentile(latencies, 0.99);
+    r.p999 = percentile(latencies, 0.999);
+    return r;
+}
+
+void writeJson(FILE* out, const std::vector<result>& results, const options& opts) {
+    char date[32];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(out, "{\n");
+    fprintf(out, "  \"context\": {\n");
+    fprintf(out, "    \"date\": \"%s\",\n", date);
+    fprintf(out, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(out, "    \"compiler\": \"%s\",\n", __VERSION__);
+    fprintf(out, "    \"repetitions\": %d,\n", opts.repetitions);
+    fprintf(out, "    \"scale\": %g\n", opts.scale);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const result& r = results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"ops\": %llu, \"ops_per_sec\": %.1f, "
+                "\"p50_ns\": %lld, \"p99_ns\": %lld, \"p999_ns\": %lld, \"allocs_per_op\": %.3f}%s\n",
+                r.name.c_str(), static_cast<unsigned long long>(r.ops), r.opsPerSec,
+                static_cast<long long>(r.p50), static_cast<long long>(r.p99), static_cast<long long>(r.p999),
+                r.allocsPerOp, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n");
+    fprintf(out, "}\n");
+}
+
+bool startsWith(const char* arg, const char* prefix, const char** value) {
+    size_t n = strlen(prefix);
+    if (strncmp(arg, prefix, n) != 0) {
+        return false;
+    }
+    *value = arg + n;
+    return true;
+}
+
+void usage(const char* program) {
+    fprintf(stderr, "usage: %s [--filter=<substring>] [--repetitions=<n>] [--scale=<factor>]\n"
+            "       [--format=console|json] [--out=<json file>]\n", program);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    options opts;
+    opts.format = "console";
+    opts.repetitions = 3;
+    opts.scale = 1.0;
+    for (int i = 1; i < argc; i++) {
+        const char* value;
+        if (startsWith(argv[i], "--filter=", &value)) {
+            opts.filter = value;
+        } else if (startsWith(argv[i], "--format=", &value)) {
+            opts.format = value;
+        } else if (startsWith(argv[i], "--out=", &value)) {
+            opts.out = value;
+        } else if (startsWith(argv[i], "--repetitions=", &value)) {
+            opts.repetitions = std::max(1, atoi(value));
+        } else if (startsWith(argv[i], "--scale=", &value)) {
+            opts.scale = atof(value);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (opts.format != "console" && opts.format != "json") {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<bench::Benchmark> benchmarks = bench::Registry();
+    std::sort(benchmarks.begin(), benchmarks.end(), [](const bench::Benchmark& a, const bench::Benchmark& b) {
+        return strcmp(a.name, b.name) < 0;
+    });
+    bool console = opts.format == "console";
+    if (console) {
+        printf("%-44s %14s %10s %10s %10s %10s\n", "benchmark", "ops/s", "p50 us", "p99 us", "p999 us", "allocs/op");
+    }
+    std::vector<result> results;
+    for (const bench::Benchmark& b : benchmarks) {
+        if (std::string(b.name).find(opts.filter) == std::string::npos) {
+            continue;
+        }
+        result r = run(b, opts);
+        if (console) {
+            printf("%-44s %14.0f %10.2f %10.2f %10.2f %10.2f\n", r.name.c_str(), r.opsPerSec,
+                    r.p50 / 1e3, r.p99 / 1e3, r.p999 / 1e3, r.allocsPerOp);
+            fflush(stdout);
+        }
+        results.push_back(r);
+    }
+    if (!console) {
+        writeJson(stdout, results, opts);
+    }
+    if (!opts.out.empty()) {
+        FILE* out = fopen(opts.out.c_str(), "w");
+        if (out == nullptr) {
+            perror(opts.out.c_str());
+            return 1;
+        }
+        writeJson(out, results, opts);
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <thread>
+#include <vector>
+#include "ccl/blocking_queue.h"
+#include "bench.h"
+
+namespace {
+
+// Producers push timestamps and consumers pop them, recording the time each
+// element spent in the queue.
+void pushPop(bench::State& state, int nproducers, int nconsumers) {
+    ccl::BlockingQueue<int64_t> queue;
+    uint64_t perProducer = state.Iterations() / nproducers;
+    uint64_t ops = perProducer * nproducers;
+    std::vector<std::vector<int64_t>> latencies(nconsumers);
+    for (int i = 0; i < nconsumers; i++) {
+        latencies[i].reserve(ops / nconsumers + 1);
+    }
+
+    state.Start();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nconsumers; i++) {
+        uint64_t count = ops / nconsumers + (static_cast<uint64_t>(i) < ops % nconsumers ? 1 : 0);
+        threads.emplace_back([&queue, &latencies, i, count]() {
+            for (uint64_t j = 0; j < count; j++) {
+                int64_t pushed = queue.Pop();
+                latencies[i].push_back(bench::Now() - pushed);
+            }
+        });
+    }
+    for (int i = 0; i < nproducers; i++) {
+        threads.emplace_back([&queue, perProducer]() {
+            for (uint64_t j = 0; j < perProducer; j++) {
+                queue.Push(bench::Now());
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    state.Stop();
+
+    state.SetOps(ops);
+    for (auto& l : latencies) {
+        state.AddLatencies(l);
+    }
+}
+
+} // namespace
+
+CCL_BENCHMARK(BlockingQueue_PushPop_1x1, 200000) {
+    pushPop(state, 1, 1);
+}
+
+CCL_BENCHMARK(BlockingQueue_PushPop_4x4, 200000) {
+    pushPop(state, 4, 4);
+}
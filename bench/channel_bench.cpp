@@ -0,0 +1,43 @@
+#include <thread>
+#include <vector>
+#include "ccl/channel.h"
+#include "bench.h"
+
+namespace {
+
+// Sends a message to another thread and waits for it to come back.
+void pingPong(bench::State& state, size_t capacity) {
+    uint64_t n = state.Iterations();
+    std::vector<int64_t> latencies(n);
+    ccl::Channel<int64_t> ping(capacity);
+    ccl::Channel<int64_t> pong(capacity);
+
+    state.Start();
+    std::thread echo([&]() {
+        int64_t message;
+        while (ping.Receive(message)) {
+            pong.Send(message);
+        }
+    });
+    for (uint64_t i = 0; i < n; i++) {
+        int64_t sent = bench::Now();
+        ping.Send(sent);
+        pong.Receive();
+        latencies[i] = bench::Now() - sent;
+    }
+    ping.Close();
+    echo.join();
+    state.Stop();
+
+    state.AddLatencies(latencies);
+}
+
+} // namespace
+
+CCL_BENCHMARK(Channel_PingPong_Unbuffered, 50000) {
+    pingPong(state, 0);
+}
+
+CCL_BENCHMARK(Channel_PingPong_Buffered, 50000) {
+    pingPong(state, 1);
+}
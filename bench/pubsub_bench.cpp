@@ -0,0 +1,93 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include "ccl/countdown_latch.h"
+#include "ccl/pubsub.h"
+#include "bench.h"
+
+using ccl::any;
+using ccl::any_cast;
+
+namespace {
+
+const int kSubscriberCount = 16;
+
+// Subscribers on a shared pool that record the time from publishing until
+// they receive each message.
+class subscribers final {
+private:
+    std::vector<std::vector<int64_t>> m_latencies;
+    ccl::CountdownLatch m_latch;
+    std::vector<std::shared_ptr<ccl::Actor>> m_actors;
+
+public:
+    subscribers(std::shared_ptr<ccl::ThreadPool> pool, uint64_t messages)
+            : m_latencies(kSubscriberCount), m_latch(kSubscriberCount) {
+        for (int i = 0; i < kSubscriberCount; i++) {
+            std::vector<int64_t>* latencies = &m_latencies[i];
+            latencies->reserve(messages);
+            ccl::CountdownLatch* latch = &m_latch;
+            m_actors.push_back(std::make_shared<ccl::Actor>(pool, [latencies, latch, messages](any& msg) {
+                latencies->push_back(bench::Now() - any_cast<int64_t>(msg));
+                if (latencies->size() == messages) {
+                    latch->CountDown();
+                }
+                return any();
+            }));
+        }
+    }
+
+    const std::vector<std::shared_ptr<ccl::Actor>>& Actors() const {
+        return m_actors;
+    }
+
+    void Await() {
+        m_latch.Await();
+    }
+
+    void Report(bench::State& state) {
+        for (auto& l : m_latencies) {
+            state.AddLatencies(l);
+        }
+    }
+};
+
+} // namespace
+
+// Publishes to one topic with kSubscriberCount subscribers.
+CCL_BENCHMARK(PubSub_Publish_FanOut, 20000) {
+    uint64_t n = state.Iterations();
+    auto pool = std::make_shared<ccl::ThreadPool>(4);
+    subscribers subs(pool, n);
+    ccl::PubSub broker;
+    broker.Subscribe("bench/topic", subs.Actors());
+
+    state.Start();
+    for (uint64_t i = 0; i < n; i++) {
+        broker.Publish("bench/topic", any(bench::Now()));
+    }
+    subs.Await();
+    state.Stop();
+
+    subs.Report(state);
+}
+
+// Multicasts to kSubscriberCount topics matched by a wildcard pattern.
+CCL_BENCHMARK(PubSub_Multicast_FanOut, 20000) {
+    uint64_t n = state.Iterations();
+    auto pool = std::make_shared<ccl::ThreadPool>(4);
+    subscribers subs(pool, n);
+    ccl::PubSub broker;
+    for (int i = 0; i < kSubscriberCount; i++) {
+        broker.Subscribe("bench/" + std::to_string(i) + "/value", subs.Actors()[i]);
+    }
+
+    state.Start();
+    for (uint64_t i = 0; i < n; i++) {
+        broker.Multicast("bench/+/value", any(bench::Now()));
+    }
+    subs.Await();
+    state.Stop();
+
+    subs.Report(state);
+}
@@ -0,0 +1,36 @@
+#include <chrono>
+#include <vector>
+#include "ccl/scheduler.h"
+#include "bench.h"
+
+namespace {
+
+// Schedules a timer far in the future and cancels it right away, as
+// timeouts that are cancelled once the awaited reply arrives do.
+void churn(bench::State& state, ccl::SchedulerBackend backend) {
+    uint64_t n = state.Iterations();
+    std::vector<int64_t> latencies(n);
+    ccl::Scheduler scheduler(backend);
+    auto execTime = std::chrono::steady_clock::now() + std::chrono::hours(1);
+
+    state.Start();
+    for (uint64_t i = 0; i < n; i++) {
+        int64_t start = bench::Now();
+        ccl::TimerHandle handle = scheduler.Schedule(execTime, []() {});
+        handle.Cancel();
+        latencies[i] = bench::Now() - start;
+    }
+    state.Stop();
+
+    state.AddLatencies(latencies);
+}
+
+} // namespace
+
+CCL_BENCHMARK(Scheduler_ScheduleCancel_Heap, 200000) {
+    churn(state, ccl::SchedulerBackend::Heap);
+}
+
+CCL_BENCHMARK(Scheduler_ScheduleCancel_TimingWheel, 200000) {
+    churn(state, ccl::SchedulerBackend::TimingWheel);
+}
@@ -0,0 +1,79 @@
+#include <vector>
+#include "ccl/countdown_latch.h"
+#include "ccl/thread_pool.h"
+#include "bench.h"
+
+namespace {
+
+// Dispatches tasks from one thread and records the time from Dispatch until
+// a worker starts the task.
+template<typename Metrics = ccl::NoMetrics>
+void dispatch(bench::State& state, ccl::DispatchMode mode) {
+    const size_t nthreads = 4;
+    uint64_t n = state.Iterations();
+    std::vector<int64_t> latencies(n);
+    ccl::CountdownLatch latch(static_cast<unsigned int>(n));
+    ccl::BasicThreadPool<ccl::BlockingQueue<ccl::Task>, Metrics> pool(nthreads, SIZE_MAX, mode);
+
+    state.Start();
+    for (uint64_t i = 0; i < n; i++) {
+        int64_t dispatched = bench::Now();
+        pool.Dispatch([&latencies, &latch, i, dispatched]() {
+            latencies[i] = bench::Now() - dispatched;
+            latch.CountDown();
+        });
+    }
+    latch.Await();
+    state.Stop();
+
+    state.AddLatencies(latencies);
+}
+
+// A task that spawns two children from its worker until depth reaches 0,
+// so that the tasks go through the workers' own deques.
+struct spawner {
+    ccl::ThreadPool* pool;
+    ccl::CountdownLatch* latch;
+    unsigned int depth;
+
+    void operator()() {
+        if (depth > 0) {
+            pool->Dispatch(spawner{pool, latch, depth - 1});
+            pool->Dispatch(spawner{pool, latch, depth - 1});
+        }
+        latch->CountDown();
+    }
+};
+
+} // namespace
+
+CCL_BENCHMARK(ThreadPool_Dispatch_SharedQueue, 200000) {
+    dispatch(state, ccl::DispatchMode::SharedQueue);
+}
+
+CCL_BENCHMARK(ThreadPool_Dispatch_WorkStealing, 200000) {
+    dispatch(state, ccl::DispatchMode::WorkStealing);
+}
+
+// The same with ThreadPoolMetrics, to see what collecting the statistics costs.
+CCL_BENCHMARK(ThreadPool_Dispatch_SharedQueue_Metrics, 200000) {
+    dispatch<ccl::ThreadPoolMetrics>(state, ccl::DispatchMode::SharedQueue);
+}
+
+// Spawns a binary tree of tasks from the workers, which should not allocate.
+CCL_BENCHMARK(ThreadPool_Spawn_WorkStealing, 200000) {
+    unsigned int depth = 0;
+    while ((uint64_t(2) << (depth + 1)) - 1 <= state.Iterations()) {
+        depth++;
+    }
+    uint64_t tasks = (uint64_t(2) << depth) - 1;
+    ccl::CountdownLatch latch(static_cast<unsigned int>(tasks));
+    ccl::ThreadPool pool(4, SIZE_MAX, ccl::DispatchMode::WorkStealing);
+
+    state.Start();
+    pool.Dispatch(spawner{&pool, &latch, depth});
+    latch.Await();
+    state.Stop();
+
+    state.SetOps(tasks);
+}
@@ -0,0 +1,38 @@
+#include "ccl/trace.h"
+#include "bench.h"
+
+// The cost of a trace point on the calling thread.
+CCL_BENCHMARK(Tracer_Instant, 1000000) {
+    uint64_t n = state.Iterations();
+    ccl::Tracer::Instant("warm up"); // registers the thread's buffer
+
+    state.Start();
+    for (uint64_t i = 0; i < n; i++) {
+        ccl::Tracer::Instant("bench", i);
+    }
+    state.Stop();
+}
+
+CCL_BENCHMARK(Tracer_Scope, 1000000) {
+    uint64_t n = state.Iterations();
+    ccl::Tracer::Instant("warm up");
+
+    state.Start();
+    for (uint64_t i = 0; i < n; i++) {
+        ccl::TraceScope scope("bench");
+    }
+    state.Stop();
+}
+
+CCL_BENCHMARK(Tracer_Disabled, 1000000) {
+    uint64_t n = state.Iterations();
+    ccl::Tracer::SetEnabled(false);
+
+    state.Start();
+    for (uint64_t i = 0; i < n; i++) {
+        ccl::Tracer::Instant("bench", i);
+    }
+    state.Stop();
+
+    ccl::Tracer::SetEnabled(true);
+}
@@ -0,0 +1,55 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include "ccl/any.h"
+
+static const int kCopyCount = 1000; // e.g. one copy per subscriber of a broadcast
+
+namespace {
+
+std::atomic<long> allocationCount(0);
+
+struct Large {
+    char data[64];
+};
+
+template<typename ValueType>
+void measure(const char* name, const ValueType& value) {
+    ccl::any message = value;
+    long before = allocationCount;
+    for (int i = 0; i < kCopyCount; i++) {
+        ccl::any copy = message;
+    }
+    long allocations = allocationCount - before;
+    printf("%-24s %6.2f allocs/copy\n", name, static_cast<double>(allocations) / kCopyCount);
+}
+
+} // namespace
+
+// Counts every allocation made through the global operator new.
+// The default operator delete releases the memory with free().
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    allocationCount++;
+    void* p = std::malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+int main(void) {
+    measure("int", 1);
+    measure("double", 2.0);
+    measure("std::shared_ptr<Large>", std::make_shared<Large>());
+    measure("Large", Large{});
+
+    // Output:
+    // int                        0.00 allocs/copy
+    // double                     0.00 allocs/copy
+    // std::shared_ptr<Large>     0.00 allocs/copy
+    // Large                      1.00 allocs/copy
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "ccl/countdown_latch.h"
+#include "ccl/cyclic_barrier.h"
+#include "ccl/phaser.h"
+
+static const int kPhaseCount = 20000;
+
+namespace {
+
+// Runs kPhaseCount phases on nthreads threads and returns the phases per
+// second. Every thread calls arrive(thread, phase) once per phase.
+double measure(int nthreads, std::function<void(int, int)> arrive) {
+    using namespace std::chrono;
+
+    auto start = steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++) {
+        threads.emplace_back([&arrive, i]() {
+            for (int phase = 0; phase < kPhaseCount; phase++) {
+                arrive(i, phase);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    return kPhaseCount / duration_cast<duration<double>>(steady_clock::now() - start).count();
+}
+
+// The baseline: a new single-use latch per phase. The first thread creates
+// the latch of the next phase before it arrives at the current one.
+double measureLatches(int nthreads) {
+    std::vector<std::unique_ptr<ccl::CountdownLatch>> latches(kPhaseCount + 1);
+    latches[0].reset(new ccl::CountdownLatch(nthreads));
+    return measure(nthreads, [&latches, nthreads](int thread, int phase) {
+        if (thread == 0) {
+            latches[phase + 1].reset(new ccl::CountdownLatch(nthreads));
+        }
+        latches[phase]->CountDown();
+        latches[phase]->Await();
+    });
+}
+
+double measureBarrier(int nthreads) {
+    ccl::CyclicBarrier barrier(nthreads);
+    return measure(nthreads, [&barrier](int, int) {
+        barrier.Await();
+    });
+}
+
+double measurePhaser(int nthreads) {
+    ccl::Phaser phaser(nthreads);
+    return measure(nthreads, [&phaser](int, int) {
+        phaser.ArriveAndAwaitAdvance();
+    });
+}
+
+} // namespace
+
+int main(void) {
+    for (int nthreads : {2, 4, 8}) {
+        printf("%d threads\n", nthreads);
+        printf("  %-16s %10.0f phases/s\n", "latch per phase", measureLatches(nthreads));
+        printf("  %-16s %10.0f phases/s\n", "CyclicBarrier", measureBarrier(nthreads));
+        printf("  %-16s %10.0f phases/s\n", "Phaser", measurePhaser(nthreads));
+    }
+
+    // Output:
+    // 2 threads
+    //   latch per phase  <phases> phases/s
+    //   CyclicBarrier    <phases> phases/s
+    //   Phaser           <phases> phases/s
+    // 4 threads
+    //   ...
+    // 8 threads
+    //   ...
+    return 0;
+}
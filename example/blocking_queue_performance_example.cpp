@@ -0,0 +1,57 @@
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "ccl/blocking_queue.h"
+#include "ccl/ring_buffer_queue.h"
+
+static const int kCapacity = 1024;
+static const int kOperationCount = 1 << 20;
+
+namespace {
+
+// Runs n producers and n consumers and returns the number of transferred elements per second.
+template<typename Queue>
+double measure(int n) {
+    using namespace std::chrono;
+
+    Queue queue(kCapacity);
+    const int perThread = kOperationCount / n;
+    std::vector<std::thread> threads;
+    auto start = steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < perThread; j++) {
+                queue.Push(j);
+            }
+        });
+        threads.emplace_back([&]() {
+            for (int j = 0; j < perThread; j++) {
+                queue.Pop();
+            }
+        });
+    }
+    for (std::thread& th : threads) {
+        th.join();
+    }
+    double elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    return perThread * n / elapsed;
+}
+
+} // namespace
+
+int main(void) {
+    printf("%-10s %18s %18s\n", "threads", "BlockingQueue", "RingBufferQueue");
+    for (int n = 1; n <= 64; n *= 2) {
+        double locked = measure<ccl::BlockingQueue<int>>(n);
+        double lockFree = measure<ccl::RingBufferQueue<int>>(n);
+        printf("%3dx%-6d %14.0f/sec %14.0f/sec\n", n, n, locked, lockFree);
+    }
+
+    // Output:
+    // threads         BlockingQueue    RingBufferQueue
+    //   1x1            <ops>/sec          <ops>/sec
+    //   ...
+    //  64x64           <ops>/sec          <ops>/sec
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "ccl/channel.h"
+
+static const int kMessageCount = 1000000;
+
+namespace {
+
+// Passes kMessageCount messages through a producer, a filter stage and a
+// consumer connected by channels, and returns the time per message.
+double measure(size_t capacity, int messageCount) {
+    using namespace std::chrono;
+
+    ccl::Channel<int> source(capacity);
+    ccl::Channel<int> sink(capacity);
+    auto start = steady_clock::now();
+    std::thread producer([&]() {
+        for (int i = 0; i < messageCount; i++) {
+            source.Send(i);
+        }
+        source.Close();
+    });
+    std::thread filter([&]() {
+        int message;
+        while (source.Receive(message)) {
+            sink.Send(message * 2);
+        }
+        sink.Close();
+    });
+    long sum = 0;
+    int message;
+    while (sink.Receive(message)) {
+        sum += message;
+    }
+    producer.join();
+    filter.join();
+    if (sum != static_cast<long>(messageCount) * (messageCount - 1)) {
+        printf("unexpected sum: %ld\n", sum);
+    }
+    return duration_cast<duration<double, std::nano>>(steady_clock::now() - start).count() / messageCount;
+}
+
+} // namespace
+
+int main(void) {
+    printf("%-14s %8.1f ns/message\n", "unbuffered", measure(0, kMessageCount / 10));
+    printf("%-14s %8.1f ns/message\n", "capacity 1024", measure(1024, kMessageCount));
+
+    // Output:
+    // unbuffered     <ns> ns/message
+    // capacity 1024  <ns> ns/message
+    return 0;
+}
@@ -0,0 +1,36 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ccl/actor.h"
+#include "ccl/future.h"
+#include "ccl/thread_pool.h"
+
+int main(void) {
+    auto pool = std::make_shared<ccl::ThreadPool>(2);
+    ccl::Actor doubler(pool, [](ccl::any& msg) {
+        return ccl::any_cast<int>(msg) * 2;
+    });
+
+    // Chains the replies without blocking a thread per request.
+    std::vector<ccl::Future<int>> futures;
+    for (int i = 1; i <= 3; i++) {
+        futures.push_back(doubler.Ask(i).Then([&](ccl::any r) {
+            return doubler.Ask(std::move(r));
+        })
+        .Then(pool, [](ccl::any r) {
+            return ccl::any_cast<int>(r) + 1;
+        }));
+    }
+
+    std::vector<int> results = ccl::WhenAll(std::move(futures)).Get();
+    for (int result : results) {
+        std::cout << "result: " << result << std::endl;
+    }
+
+    // Output:
+    // result: 5
+    // result: 9
+    // result: 13
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ccl/countdown_latch.h"
+#include "ccl/pubsub.h"
+#include "ccl/thread_pool.h"
+
+static const int kSubscriberCount = 100;
+static const int kPublishCount = 10000;
+static const int kBroadcastSubscriberCount = 500;
+static const int kBroadcastCount = 20;
+static const size_t kPayloadSize = 64 * 1024;
+static const int kTopicCount = 200000;
+static const int kMulticastCount = 10000;
+
+namespace {
+
+// Fans kPublishCount messages out to every subscriber and returns the cost per delivered message.
+template<typename Func>
+double measure(Func publish) {
+    using namespace std::chrono;
+
+    const int deliveries = kSubscriberCount * kPublishCount;
+    auto pool = std::make_shared<ccl::ThreadPool>(4);
+    ccl::CountdownLatch latch(deliveries);
+    ccl::PubSub broker;
+    for (int i = 0; i < kSubscriberCount; i++) {
+        broker.Subscribe("/topic", std::make_shared<ccl::Actor>(pool, [&](ccl::any& msg) {
+            latch.CountDown();
+            return 0;
+        }));
+    }
+    auto start = steady_clock::now();
+    for (int i = 0; i < kPublishCount; i++) {
+        publish(broker, ccl::any(i));
+    }
+    latch.Await();
+    return duration_cast<duration<double, std::nano>>(steady_clock::now() - start).count() / deliveries;
+}
+
+// Sends kBroadcastCount large payloads to every subscriber and returns the time per broadcast.
+template<typename Func>
+double measureBroadcast(Func broadcast) {
+    using namespace std::chrono;
+
+    auto pool = std::make_shared<ccl::ThreadPool>(4);
+    ccl::CountdownLatch latch(kBroadcastSubscriberCount * kBroadcastCount);
+    ccl::PubSub broker;
+    for (int i = 0; i < kBroadcastSubscriberCount; i++) {
+        broker.Subscribe("/topic/" + std::to_string(i), std::make_shared<ccl::Actor>(pool, [&](ccl::any& msg) {
+            // Reading through a const reference keeps a shared payload shared.
+            ccl::any_cast<const std::vector<char>&>(msg);
+            latch.CountDown();
+            return 0;
+        }));
+    }
+    const ccl::any payload = std::vector<char>(kPayloadSize);
+    auto start = steady_clock::now();
+    for (int i = 0; i < kBroadcastCount; i++) {
+        broadcast(broker, payload);
+    }
+    latch.Await();
+    return duration_cast<duration<double, std::micro>>(steady_clock::now() - start).count() / kBroadcastCount;
+}
+
+// Multicasts to one device among kTopicCount topics and returns the time per call.
+double measureMulticast() {
+    using namespace std::chrono;
+
+    auto pool = std::make_shared<ccl::ThreadPool>(1);
+    auto actor = std::make_shared<ccl::Actor>(pool, [](ccl::any& msg) {
+        return 0;
+    });
+    ccl::PubSub broker;
+    for (int i = 0; i < kTopicCount; i++) {
+        broker.Subscribe("/device/" + std::to_string(i) + "/temperature", actor);
+    }
+    auto start = steady_clock::now();
+    for (int i = 0; i < kMulticastCount; i++) {
+        broker.Multicast("/device/" + std::to_string(i) + "/+", i);
+    }
+    return duration_cast<duration<double, std::micro>>(steady_clock::now() - start).count() / kMulticastCount;
+}
+
+} // namespace
+
+int main(void) {
+    double send = measure([](ccl::PubSub& broker, const ccl::any& msg) {
+        for (auto& actor : broker.GetSubscribers("/topic")) {
+            actor->Send(msg);
+        }
+    });
+    double tell = measure([](ccl::PubSub& broker, const ccl::any& msg) {
+        broker.Publish("/topic", msg);
+    });
+    printf("%-24s %8.1f ns/message\n", "Actor::Send", send);
+    printf("%-24s %8.1f ns/message\n", "PubSub::Publish (Tell)", tell);
+
+    double copied = measureBroadcast([](ccl::PubSub& broker, const ccl::any& msg) {
+        for (auto& topic : broker.GetTopics()) {
+            for (auto& actor : broker.GetSubscribers(topic)) {
+                actor->Tell(msg); // copies the payload per subscriber
+            }
+        }
+    });
+    double shared = measureBroadcast([](ccl::PubSub& broker, const ccl::any& msg) {
+        broker.Broadcast(msg);
+    });
+    printf("%-24s %8.1f us/broadcast\n", "copied payload", copied);
+    printf("%-24s %8.1f us/broadcast\n", "PubSub::Broadcast", shared);
+    printf("%-24s %8.1f us/multicast\n", "PubSub::Multicast", measureMulticast());
+
+    // Output:
+    // Actor::Send              <ns> ns/message
+    // PubSub::Publish (Tell)   <ns> ns/message
+    // copied payload           <us> us/broadcast
+    // PubSub::Broadcast        <us> us/broadcast
+    // PubSub::Multicast        <us> us/multicast
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "ccl/countdown_latch.h"
+#include "ccl/scheduler.h"
+
+static const int kTaskCount = 2000;
+static const int kInterval = 250; // [us]
+
+namespace {
+
+// Schedules kTaskCount tasks kInterval apart and prints a histogram of how
+// late they fired.
+void measure(const char* name, std::chrono::nanoseconds spinThreshold) {
+    using namespace std::chrono;
+
+    std::vector<int64_t> delays(kTaskCount); // [ns]
+    ccl::CountdownLatch latch(kTaskCount);
+    ccl::Scheduler scheduler;
+    scheduler.SetSpinThreshold(spinThreshold);
+    auto start = steady_clock::now() + milliseconds(10);
+    for (int i = 0; i < kTaskCount; i++) {
+        auto execTime = start + microseconds(kInterval) * i;
+        scheduler.Schedule(execTime, [&delays, &latch, execTime, i]() {
+            delays[i] = duration_cast<nanoseconds>(steady_clock::now() - execTime).count();
+            latch.CountDown();
+        });
+    }
+    latch.Await();
+
+    std::sort(delays.begin(), delays.end());
+    printf("%s: p50 %.1f us, p99 %.1f us, max %.1f us\n", name,
+            delays[kTaskCount / 2] / 1e3, delays[kTaskCount * 99 / 100] / 1e3, delays.back() / 1e3);
+    const int64_t bounds[] = {1000, 10000, 50000, 100000, 1000000}; // [ns]
+    size_t counted = 0;
+    for (int64_t bound : bounds) {
+        size_t count = std::lower_bound(delays.begin(), delays.end(), bound) - delays.begin();
+        printf("  < %7.1f us %6zu\n", bound / 1e3, count - counted);
+        counted = count;
+    }
+    printf("  >=%7.1f us %6zu\n", bounds[4] / 1e3, delays.size() - counted);
+}
+
+} // namespace
+
+int main(void) {
+    measure("sleep", std::chrono::nanoseconds(0));
+    measure("spin-then-sleep", std::chrono::milliseconds(1));
+
+    // Output:
+    // sleep: p50 <us> us, p99 <us> us, max <us> us
+    //   <     1.0 us <count>
+    //   <    10.0 us <count>
+    //   <    50.0 us <count>
+    //   <   100.0 us <count>
+    //   <  1000.0 us <count>
+    //   >= 1000.0 us <count>
+    // spin-then-sleep: p50 <us> us, p99 <us> us, max <us> us
+    //   ...
+    return 0;
+}
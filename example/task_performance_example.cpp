@@ -0,0 +1,97 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include "ccl/actor.h"
+#include "ccl/countdown_latch.h"
+#include "ccl/ring_buffer_queue.h"
+#include "ccl/task.h"
+#include "ccl/thread_pool.h"
+
+static const int kTaskCount = 100000;
+
+namespace {
+
+std::atomic<long> allocationCount(0);
+
+// A typical closure: bigger than the small buffer of std::function.
+struct Closure {
+    std::atomic<int>* counter;
+    void* context[4];
+
+    void operator()() {
+        (*counter)++;
+    }
+};
+
+template<typename Func>
+void measure(const char* name, Func func) {
+    using namespace std::chrono;
+
+    long before = allocationCount;
+    auto start = steady_clock::now();
+    func();
+    double elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    long allocations = allocationCount - before;
+    printf("%-36s %8.2f allocs/task %12.0f tasks/sec\n", name,
+            static_cast<double>(allocations) / kTaskCount, kTaskCount / elapsed);
+}
+
+} // namespace
+
+// Counts every allocation made through the global operator new.
+// The default operator delete releases the memory with free().
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    allocationCount++;
+    void* p = std::malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+int main(void) {
+    std::atomic<int> counter(0);
+
+    measure("std::function<void()>", [&]() {
+        for (int i = 0; i < kTaskCount; i++) {
+            std::function<void()> func(Closure{&counter, {}});
+            func();
+        }
+    });
+    measure("ccl::Task", [&]() {
+        for (int i = 0; i < kTaskCount; i++) {
+            ccl::Task task(Closure{&counter, {}});
+            task();
+        }
+    });
+    {
+        ccl::BasicThreadPool<ccl::RingBufferQueue<ccl::Task>> pool(1, 1024);
+        measure("Dispatch (RingBufferQueue)", [&]() {
+            ccl::CountdownLatch latch(kTaskCount);
+            for (int i = 0; i < kTaskCount; i++) {
+                pool.Dispatch([&latch]() { latch.CountDown(); });
+            }
+            latch.Await();
+        });
+    }
+    {
+        auto actor = std::make_shared<ccl::Actor>([](ccl::any& msg) -> ccl::any {
+            return 0;
+        });
+        measure("Actor::Send", [&]() {
+            for (int i = 0; i < kTaskCount; i++) {
+                actor->Send(i).get();
+            }
+        });
+    }
+
+    // Output:
+    // std::function<void()>                    1.00 allocs/task    <tasks>/sec
+    // ccl::Task                                0.00 allocs/task    <tasks>/sec
+    // Dispatch (RingBufferQueue)               0.00 allocs/task    <tasks>/sec
+    // Actor::Send                              <n>  allocs/task    <tasks>/sec
+    return 0;
+}
@@ -0,0 +1,45 @@
+#define CCL_ENABLE_TRACING
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include "ccl/actor.h"
+#include "ccl/countdown_latch.h"
+#include "ccl/scheduler.h"
+#include "ccl/thread_pool.h"
+#include "ccl/trace.h"
+
+static const int kMessageCount = 100;
+
+int main(void) {
+    using namespace std::chrono;
+
+    CCL_TRACE_THREAD_NAME("main");
+    {
+        // A timer sends messages to an actor on a pool, which dispatches work to the pool.
+        auto pool = std::make_shared<ccl::ThreadPool>(2);
+        ccl::CountdownLatch latch(kMessageCount);
+        ccl::Actor actor(pool, [&](ccl::any& msg) {
+            CCL_TRACE_SCOPE("example::handle");
+            pool->Dispatch([&latch]() {
+                latch.CountDown();
+            });
+            return msg;
+        });
+        ccl::Scheduler scheduler;
+        scheduler.Schedule(steady_clock::now(), microseconds(100), kMessageCount - 1, [&actor]() {
+            actor.Tell(ccl::any(0));
+        });
+        latch.Await();
+    }
+
+    const char* path = "trace.json";
+    if (!ccl::Tracer::WriteChromeTrace(path)) {
+        printf("cannot write %s\n", path);
+        return 1;
+    }
+    printf("wrote %s, open it with chrome://tracing or https://ui.perfetto.dev\n", path);
+
+    // Output:
+    // wrote trace.json, open it with chrome://tracing or https://ui.perfetto.dev
+    return 0;
+}
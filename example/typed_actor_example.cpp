@@ -0,0 +1,39 @@
+#include <iostream>
+#include <string>
+#include "ccl/typed_actor.h"
+
+namespace {
+
+struct Point {
+    int x;
+    int y;
+};
+
+// One overload per message type; the right one is chosen at compile time.
+struct Printer {
+    void operator()(int& msg) {
+        std::cout << "int: " << msg << std::endl;
+    }
+    void operator()(std::string& msg) {
+        std::cout << "string: " << msg << std::endl;
+    }
+    void operator()(Point& p) {
+        std::cout << "Point: x=" << p.x << ", y=" << p.y << std::endl;
+    }
+};
+
+} // namespace
+
+int main(void) {
+    ccl::TypedActor<int, std::string, Point> actor(Printer{});
+    actor.Tell(1);
+    actor.Tell(std::string("2"));
+    auto future = actor.Send(Point{3, 4});
+    future.get();
+
+    // Output:
+    // int: 1
+    // string: 2
+    // Point: x=3, y=4
+    return 0;
+}
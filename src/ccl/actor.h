@@ -1,5 +1,11 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <functional>
 #include <future>
 #include <map>
@@ -7,7 +13,14 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
+#include "ccl/actor_core.h"
+#include "ccl/future.h"
+#include "ccl/histogram.h"
+#include "ccl/scheduler.h"
 #include "ccl/thread_pool.h"
+#include "ccl/trace.h"
 #ifdef CCL_USE_BOOST_ANY
  #include <boost/any.hpp>
 #else
@@ -20,57 +33,227 @@ namespace ccl {
 using any = boost::any;
 #endif // CCL_USE_BOOST_ANY
 
+// Counters of one actor, see Actor::Stats. Durations are in nanoseconds.
+struct ActorStats {
+    uint64_t received; // messages sent or told to the actor
+    uint64_t processed; // messages taken from the mailbox
+    uint64_t mailboxDepth; // messages received but not processed yet
+    uint64_t highWaterMark; // the largest mailbox depth so far
+    uint64_t runningFor; // how long the handler has been running, or 0 if it is idle
+    Histogram handlerTime; // time spent in onReceive per message
+};
+
+// Messages sent to an actor are queued in its own mailbox and processed one
+// at a time, even if the actor shares its thread pool with other actors.
+// The mailbox is dispatched to the pool only when it becomes non-empty, and
+// runs up to the throughput count of messages before yielding the worker.
 class Actor final {
 private:
-    const std::function<any(any&)> m_onReceive;
+    struct envelope {
+        any message;
+        std::unique_ptr<std::promise<any>> promise; // null for Tell and Ask
+        Promise<any> reply; // untouched, and so without a state, unless asked
+        bool asked = false;
+    };
+
+    class core final : public actorCore<core, envelope> {
+    private:
+        friend class actorCore<core, envelope>;
+
+        const std::function<any(any&)> m_onReceive;
+        // The counters below the received count are only written by the
+        // thread that holds the scheduled flag.
+        std::atomic<uint64_t> m_received;
+        std::atomic<uint64_t> m_processed;
+        std::atomic<uint64_t> m_highWaterMark;
+        std::atomic<int64_t> m_handlerStart; // [ns], 0 while no handler runs
+        AtomicHistogram m_handlerTime;
+
+    public:
+        core(std::function<any(any&)>&& onReceive, ThreadPool* pool)
+                : actorCore<core, envelope>(pool), m_onReceive(std::move(onReceive))
+                , m_received(0), m_processed(0), m_highWaterMark(0), m_handlerStart(0) {}
+
+        void Post(envelope&& e) {
+            // Counted before the push, so the processed count never exceeds it.
+            uint64_t received = m_received.fetch_add(1, std::memory_order_relaxed) + 1;
+            CCL_TRACE_INSTANT("Actor::Post", received);
+            updateHighWaterMark(received);
+            post(std::move(e));
+        }
+
+        ActorStats Stats() const {
+            ActorStats stats;
+            stats.processed = m_processed.load(std::memory_order_relaxed);
+            stats.received = std::max(m_received.load(std::memory_order_relaxed), stats.processed);
+            stats.mailboxDepth = stats.received - stats.processed;
+            stats.highWaterMark = m_highWaterMark.load(std::memory_order_relaxed);
+            int64_t start = m_handlerStart.load(std::memory_order_relaxed);
+            stats.runningFor = start != 0 ? static_cast<uint64_t>(std::max<int64_t>(now() - start, 1)) : 0;
+            m_handlerTime.AddTo(&stats.handlerTime);
+            return stats;
+        }
+
+    private:
+        void deliver(envelope& e) {
+            CCL_TRACE_SCOPE("Actor::Receive");
+            int64_t start = now();
+            m_handlerStart.store(start, std::memory_order_relaxed);
+            invoke(e);
+            int64_t end = now();
+            m_handlerStart.store(0, std::memory_order_relaxed);
+            m_handlerTime.Record(static_cast<uint64_t>(end - start));
+        }
+
+        void invoke(envelope& e) {
+            if (e.asked) {
+                try {
+                    e.reply.SetValue(m_onReceive(e.message));
+                } catch (...) {
+                    e.reply.SetException(std::current_exception());
+                }
+                return;
+            }
+            if (!e.promise) { // Tell: the result or exception is discarded
+                try {
+                    m_onReceive(e.message);
+                } catch (...) {
+                }
+                return;
+            }
+            try {
+                e.promise->set_value(m_onReceive(e.message));
+            } catch (...) {
+                e.promise->set_exception(std::current_exception());
+            }
+        }
+
+        void popped() {
+            m_processed.store(m_processed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        void updateHighWaterMark(uint64_t received) {
+            uint64_t processed = m_processed.load(std::memory_order_relaxed);
+            if (processed >= received) {
+                return;
+            }
+            uint64_t depth = received - processed;
+            uint64_t mark = m_highWaterMark.load(std::memory_order_relaxed);
+            while (depth > mark && !m_highWaterMark.compare_exchange_weak(mark, depth, std::memory_order_relaxed)) {
+            }
+        }
+
+        static int64_t now() {
+            using namespace std::chrono;
+            return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+        }
+    };
+
     std::shared_ptr<ThreadPool> m_pool;
+    std::shared_ptr<core> m_core;
+    bool m_shutdownNow;
 
 public:
     explicit Actor(std::function<any(any&)>&& onReceive)
-            : m_onReceive(std::move(onReceive)), m_pool(std::make_shared<ThreadPool>(1)) {}
+            : m_pool(std::make_shared<ThreadPool>(1))
+            , m_core(std::make_shared<core>(std::move(onReceive), m_pool.get()))
+            , m_shutdownNow(false) {}
 
     Actor(const std::shared_ptr<ThreadPool>& pool, std::function<any(any&)>&& onReceive)
-            : m_onReceive(std::move(onReceive)), m_pool(pool) {}
+            : m_pool(pool)
+            , m_core(std::make_shared<core>(std::move(onReceive), m_pool.get()))
+            , m_shutdownNow(false) {}
+
+    // The messages already sent are still processed unless SetShutdownNow(true)
+    // was called, in which case the pending ones are discarded.
+    ~Actor() {
+        if (m_shutdownNow) {
+            m_core->Stop();
+        }
+    }
 
-    ~Actor() = default;
     Actor(const Actor&) = delete;
     Actor& operator=(const Actor&) = delete;
 
     std::future<any> Send(const any& message) {
-        struct Func {
-            Actor* actor;
-            any msg;
-            any operator()() {
-                return actor->m_onReceive(msg);
-            }
-        };
-        auto task = std::make_shared<std::packaged_task<any()>>(Func{this, message});
-        m_pool->Dispatch([task]() { (*task)(); });
-        return task->get_future();
+        envelope e;
+        e.message = message;
+        e.promise.reset(new std::promise<any>());
+        std::future<any> future = e.promise->get_future();
+        m_core->Post(std::move(e));
+        return future;
     }
 
     std::future<any> Send(any&& message) {
-        struct Func {
-            Actor* actor;
-            any msg;
-            any operator()() {
-                return actor->m_onReceive(msg);
-            }
-        };
-        auto task = std::make_shared<std::packaged_task<any()>>(Func{this, std::move(message)});
-        m_pool->Dispatch([task]() { (*task)(); });
-        return task->get_future();
+        envelope e;
+        e.message = std::move(message);
+        e.promise.reset(new std::promise<any>());
+        std::future<any> future = e.promise->get_future();
+        m_core->Post(std::move(e));
+        return future;
+    }
+
+    // Like Send, but returns a Future, so the response can be handled by a
+    // continuation instead of a blocked thread. The future shares a single
+    // allocation with its promise.
+    Future<any> Ask(const any& message) {
+        envelope e;
+        e.message = message;
+        e.asked = true;
+        Future<any> future = e.reply.GetFuture();
+        m_core->Post(std::move(e));
+        return future;
+    }
+
+    Future<any> Ask(any&& message) {
+        envelope e;
+        e.message = std::move(message);
+        e.asked = true;
+        Future<any> future = e.reply.GetFuture();
+        m_core->Post(std::move(e));
+        return future;
+    }
+
+    // Sends a message without a response. Unlike Send, no promise or future
+    // is created, and the result or exception of onReceive is discarded.
+    void Tell(const any& message) {
+        envelope e;
+        e.message = message;
+        m_core->Post(std::move(e));
+    }
+
+    void Tell(any&& message) {
+        envelope e;
+        e.message = std::move(message);
+        m_core->Post(std::move(e));
+    }
+
+    // Sets how many messages are processed per dispatch before the worker
+    // is handed to other tasks of the pool.
+    void SetThroughput(size_t throughput) {
+        m_core->SetThroughput(throughput);
     }
 
     void SetShutdownNow(bool shutdownNow) {
+        m_shutdownNow = shutdownNow;
         m_pool->SetShutdownNow(shutdownNow);
     }
+
+    // Returns the counters of the actor. Any thread may call it at any time.
+    ActorStats Stats() const {
+        return m_core->Stats();
+    }
 };
 
 class ActorNameSystem final {
+public:
+    typedef std::function<void(const std::string& name, std::chrono::nanoseconds running)> SlowHandlerReport;
+
 private:
     std::map<std::string, std::shared_ptr<Actor>> m_actors;
     std::mutex m_mutex;
+    std::map<std::string, uint64_t> m_reported; // the message last reported as slow per actor
+    std::unique_ptr<Scheduler> m_watchdog; // destroyed first, since its task uses the members above
 
 public:
     ActorNameSystem() = default;
@@ -92,6 +275,73 @@ public:
         std::lock_guard<std::mutex> lock(m_mutex);
         return m_actors[name];
     }
+
+    // Returns up to n registered actors that spent the most time in their
+    // handlers, the busiest first.
+    std::vector<std::pair<std::string, ActorStats>> GetHottest(size_t n) {
+        std::vector<std::pair<std::string, ActorStats>> hottest = collectStats();
+        std::sort(hottest.begin(), hottest.end(),
+                [](const std::pair<std::string, ActorStats>& a, const std::pair<std::string, ActorStats>& b) {
+                    return a.second.handlerTime.Sum() > b.second.handlerTime.Sum();
+                });
+        if (hottest.size() > n) {
+            hottest.resize(n);
+        }
+        return hottest;
+    }
+
+    // Checks the registered actors every threshold / 2 on a scheduler thread,
+    // and calls report once for every message whose handler has been running
+    // longer than threshold. Replaces a watchdog started before.
+    void StartWatchdog(std::chrono::nanoseconds threshold, SlowHandlerReport report) {
+        StopWatchdog();
+        std::chrono::nanoseconds period = std::max<std::chrono::nanoseconds>(threshold / 2,
+                std::chrono::milliseconds(1));
+        m_watchdog.reset(new Scheduler());
+        m_watchdog->Schedule(std::chrono::steady_clock::now() + period, period, -1, [this, threshold, report]() {
+            checkHandlers(threshold, report);
+        });
+    }
+
+    void StopWatchdog() {
+        m_watchdog.reset();
+        m_reported.clear();
+    }
+
+private:
+    std::vector<std::pair<std::string, ActorStats>> collectStats() {
+        std::vector<std::pair<std::string, std::shared_ptr<Actor>>> actors;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& entry : m_actors) {
+                if (entry.second) {
+                    actors.push_back(entry);
+                }
+            }
+        }
+        std::vector<std::pair<std::string, ActorStats>> stats;
+        for (auto& entry : actors) {
+            stats.emplace_back(entry.first, entry.second->Stats());
+        }
+        return stats;
+    }
+
+    // Runs on the watchdog thread only.
+    void checkHandlers(std::chrono::nanoseconds threshold, const SlowHandlerReport& report) {
+        for (auto& entry : collectStats()) {
+            const ActorStats& stats = entry.second;
+            if (stats.runningFor <= static_cast<uint64_t>(threshold.count())) {
+                continue;
+            }
+            // The processed count stays the same while a handler runs.
+            auto reported = m_reported.find(entry.first);
+            if (reported != m_reported.end() && reported->second == stats.processed) {
+                continue;
+            }
+            m_reported[entry.first] = stats.processed;
+            report(entry.first, std::chrono::nanoseconds(stats.runningFor));
+        }
+    }
 };
 
 } // namespace ccl
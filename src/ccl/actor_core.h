@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include "ccl/mailbox.h"
+#include "ccl/thread_pool.h"
+
+namespace ccl {
+
+// The mailbox of an actor and how it runs on a thread pool, shared by Actor
+// and TypedActor. Messages are processed one at a time, even if the pool is
+// shared with other actors. The mailbox is dispatched to the pool only when
+// it becomes non-empty, and runs up to the throughput count of messages
+// before yielding the worker.
+// Derived is owned by a shared_ptr, so that an actor on a shared pool can be
+// destroyed while its mailbox is still queued. It provides
+//
+//     void deliver(Envelope& e); // processes a message
+//
+// and may hide popped(), which is called for every message taken from the
+// mailbox, including those dropped after Stop or a shutdown of the pool.
+template<typename Derived, typename Envelope>
+class actorCore : public std::enable_shared_from_this<Derived> {
+private:
+    static const size_t kDefaultThroughput = 64;
+
+    ThreadPool* const m_pool;
+    Mailbox<Envelope> m_mailbox;
+    std::atomic<bool> m_scheduled;
+    std::atomic<bool> m_stopped;
+    std::atomic<size_t> m_throughput;
+
+public:
+    explicit actorCore(ThreadPool* pool)
+            : m_pool(pool), m_scheduled(false), m_stopped(false), m_throughput(kDefaultThroughput) {}
+
+    actorCore(const actorCore&) = delete;
+    actorCore& operator=(const actorCore&) = delete;
+
+    // Drops the messages that have not been processed yet.
+    void Stop() {
+        m_stopped = true;
+    }
+
+    void SetThroughput(size_t throughput) {
+        m_throughput = throughput != 0 ? throughput : 1;
+    }
+
+protected:
+    ~actorCore() = default;
+
+    void post(Envelope&& e) {
+        m_mailbox.Push(std::move(e));
+        schedule();
+    }
+
+    void popped() {}
+
+private:
+    Derived* derived() {
+        return static_cast<Derived*>(this);
+    }
+
+    // Whoever sets the scheduled flag is the only consumer of the mailbox
+    // until it clears the flag again.
+    void schedule() {
+        while (!m_scheduled.exchange(true)) {
+            if (dispatch()) {
+                return;
+            }
+            // The pool was shut down, so the messages will never run.
+            Envelope e;
+            while (m_mailbox.Pop(&e)) {
+                derived()->popped();
+            }
+            m_scheduled = false;
+            if (m_mailbox.Empty()) {
+                return;
+            }
+        }
+    }
+
+    bool dispatch() {
+        std::shared_ptr<actorCore> self = this->shared_from_this();
+        return m_pool->Dispatch([self]() { self->run(); });
+    }
+
+    void run() {
+        while (true) {
+            Envelope e;
+            size_t throughput = m_throughput.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < throughput && m_mailbox.Pop(&e); i++) {
+                derived()->popped();
+                if (m_stopped.load(std::memory_order_relaxed)) {
+                    continue; // dropping a promise breaks it
+                }
+                derived()->deliver(e);
+            }
+            m_scheduled = false;
+            // A message pushed before the flag was cleared either is seen
+            // here or makes its sender schedule the mailbox.
+            if (m_mailbox.Empty() || m_scheduled.exchange(true)) {
+                return;
+            }
+            if (dispatch()) {
+                return;
+            }
+            // The pool is shutting down but still runs the tasks dispatched
+            // before, so keep processing the earlier messages on this worker.
+        }
+    }
+};
+
+} // namespace ccl
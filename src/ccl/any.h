@@ -9,24 +9,43 @@
 //        Peter Dimov, and James Curran
 // when:  July 2001, Aplril 2013
 
-#include <algorithm>
+#include <cstddef>
+#include <atomic>
+#include <new>
 #include <typeinfo>
 #include <type_traits>
+#include <utility>
 
 namespace ccl {
 
+// Values of up to three pointers in size that are nothrow move constructible
+// are stored inline, so holding an int or a shared_ptr never allocates.
+// Larger values are held on the heap. Each held type has a static vtable,
+// which any_cast compares by address before it falls back to type_info.
+//
+// shared() returns an any whose value, unless it is cheap to copy, is
+// reference counted, so its copies share one immutable value. Reading through any_cast by value or by
+// const reference keeps it shared; a non-const reference or pointer first
+// copies the value if it is still shared (copy-on-write).
 class any {
 public: // structors
-    any() : content(0) {}
+    any() : table(0) {}
 
     template<typename ValueType>
-    any(const ValueType& value) : content(new holder<ValueType>(value)) {}
+    any(const ValueType& value) : table(0) {
+        construct<ValueType>(value);
+    }
 
-    any(const any& other) : content(other.content ? other.content->clone() : 0) {}
+    any(const any& other) : table(0) {
+        if (other.table) {
+            other.table->clone(other.storage, storage);
+            table = other.table;
+        }
+    }
 
     // Move constructor
-    any(any&& other) noexcept : content(other.content) {
-        other.content = 0;
+    any(any&& other) noexcept : table(0) {
+        move_from(other);
     }
 
     // Perfect forwarding of ValueType
@@ -34,15 +53,21 @@ public: // structors
     any(ValueType&& value,
             typename std::enable_if<!std::is_same<any&, ValueType>::value>::type* = 0, // disable if value has type `any&`
             typename std::enable_if<!std::is_const<ValueType>::value>::type* = 0) // disable if value has type `const ValueType&&`
-            : content(new holder<typename std::decay<ValueType>::type>(static_cast<ValueType&&>(value))) {}
+            : table(0) {
+        construct<typename std::decay<ValueType>::type>(static_cast<ValueType&&>(value));
+    }
 
     ~any() {
-        delete content;
+        clear();
     }
 
 public: // modifiers
-    any& swap(any& rhs) {
-        std::swap(content, rhs.content);
+    any& swap(any& rhs) noexcept {
+        if (this != &rhs) {
+            any tmp(std::move(rhs));
+            rhs.move_from(*this);
+            move_from(tmp);
+        }
         return *this;
     }
 
@@ -52,9 +77,11 @@ public: // modifiers
     }
 
     // move assignement
-    any& operator=(any&& rhs) {
-        rhs.swap(*this);
-        any().swap(rhs);
+    any& operator=(any&& rhs) noexcept {
+        if (this != &rhs) {
+            clear();
+            move_from(rhs);
+        }
         return *this;
     }
 
@@ -67,54 +94,237 @@ public: // modifiers
 
 public: // queries
     bool empty() const {
-        return !content;
+        return !table;
     }
 
     void clear() {
-        any().swap(*this);
+        if (table) {
+            table->destroy(storage);
+            table = 0;
+        }
     }
 
     const std::type_info& type() const {
-        return content ? content->type() : typeid(void);
+        return table ? table->type() : typeid(void);
     }
 
-private: // types
-    class placeholder {
-    public: // structors
-        virtual ~placeholder() {}
+    // Returns a copy whose value is shared by all its copies.
+    // Inline values that are nothrow copy constructible, e.g. an int or a
+    // shared_ptr, are cheap to copy anyway and are returned as a plain copy,
+    // so sharing them never allocates.
+    any shared() const& {
+        any result;
+        if (table) {
+            result.table = table->share(const_cast<storage_type&>(storage), result.storage, false);
+        }
+        return result;
+    }
 
-    public: // queries
-        virtual const std::type_info& type() const = 0;
-        virtual placeholder* clone() const = 0;
+    any shared() && {
+        any result;
+        if (table) {
+            result.table = table->share(storage, result.storage, true);
+            table = 0;
+        }
+        return result;
+    }
+
+private: // types
+    typedef std::aligned_storage<3 * sizeof(void*), alignof(void*)>::type storage_type;
+
+    struct vtable {
+        const std::type_info& (*type)();
+        void (*clone)(const storage_type& src, storage_type& dst);
+        void (*move)(storage_type& src, storage_type& dst); // also destroys src
+        void (*destroy)(storage_type&);
+        void* (*get)(storage_type&, bool modify);
+        // Moves (and destroys) or copies src into dst as a shared value, and returns its vtable.
+        const vtable* (*share)(storage_type& src, storage_type& dst, bool steal);
     };
 
     template<typename ValueType>
-    class holder : public placeholder {
-    public: // structors
-        holder(const ValueType& value) : held(value) {}
-        holder(ValueType&& value) : held(static_cast<ValueType&&>(value)) {}
+    struct holder;
 
-    public: // queries
-        virtual const std::type_info& type() const {
+    template<typename ValueType>
+    struct inline_holder {
+        static ValueType& held(storage_type& s) {
+            return *reinterpret_cast<ValueType*>(&s);
+        }
+        static const std::type_info& type() {
+            return typeid(ValueType);
+        }
+        static void clone(const storage_type& src, storage_type& dst) {
+            new (&dst) ValueType(held(const_cast<storage_type&>(src)));
+        }
+        static void move(storage_type& src, storage_type& dst) {
+            new (&dst) ValueType(std::move(held(src)));
+            held(src).~ValueType();
+        }
+        static void destroy(storage_type& s) {
+            held(s).~ValueType();
+        }
+        static void* get(storage_type& s, bool) {
+            return &held(s);
+        }
+        static const vtable* share(storage_type& src, storage_type& dst, bool steal) {
+            return share(src, dst, steal, std::integral_constant<bool,
+                    std::is_nothrow_copy_constructible<ValueType>::value>());
+        }
+        static const vtable* share(storage_type& src, storage_type& dst, bool steal, std::true_type) {
+            if (steal) {
+                move(src, dst);
+            } else {
+                clone(src, dst);
+            }
+            return any::holder<ValueType>::table();
+        }
+        static const vtable* share(storage_type& src, storage_type& dst, bool steal, std::false_type) {
+            // e.g. a std::string fits inline, but copying it may allocate
+            if (steal) {
+                shared_holder<ValueType>::construct(dst, std::move(held(src)));
+                destroy(src);
+            } else {
+                shared_holder<ValueType>::construct(dst, held(src));
+            }
+            return any::holder<ValueType>::shared_table();
+        }
+        template<typename Arg>
+        static void construct(storage_type& s, Arg&& value) {
+            new (&s) ValueType(std::forward<Arg>(value));
+        }
+    };
+
+    template<typename ValueType>
+    struct heap_holder {
+        static ValueType*& held(storage_type& s) {
+            return *reinterpret_cast<ValueType**>(&s);
+        }
+        static const std::type_info& type() {
             return typeid(ValueType);
         }
+        static void clone(const storage_type& src, storage_type& dst) {
+            new (&dst) ValueType*(new ValueType(*held(const_cast<storage_type&>(src))));
+        }
+        static void move(storage_type& src, storage_type& dst) {
+            new (&dst) ValueType*(held(src));
+        }
+        static void destroy(storage_type& s) {
+            delete held(s);
+        }
+        static void* get(storage_type& s, bool) {
+            return held(s);
+        }
+        static const vtable* share(storage_type& src, storage_type& dst, bool steal) {
+            if (steal) {
+                shared_holder<ValueType>::construct(dst, std::move(*held(src)));
+                destroy(src);
+            } else {
+                shared_holder<ValueType>::construct(dst, *held(src));
+            }
+            return any::holder<ValueType>::shared_table();
+        }
+        template<typename Arg>
+        static void construct(storage_type& s, Arg&& value) {
+            new (&s) ValueType*(new ValueType(std::forward<Arg>(value)));
+        }
+    };
 
-        virtual placeholder* clone() const {
-            return new holder(held);
+    template<typename ValueType>
+    struct shared_holder {
+        struct block {
+            std::atomic<long> refs;
+            ValueType value; // immutable while refs > 1
+
+            template<typename Arg>
+            explicit block(Arg&& arg) : refs(1), value(std::forward<Arg>(arg)) {}
+        };
+
+        static block*& held(storage_type& s) {
+            return *reinterpret_cast<block**>(&s);
+        }
+        static const std::type_info& type() {
+            return typeid(ValueType);
+        }
+        static void clone(const storage_type& src, storage_type& dst) {
+            block* b = held(const_cast<storage_type&>(src));
+            b->refs.fetch_add(1, std::memory_order_relaxed);
+            new (&dst) block*(b);
+        }
+        static void move(storage_type& src, storage_type& dst) {
+            new (&dst) block*(held(src));
         }
+        static void destroy(storage_type& s) {
+            block* b = held(s);
+            if (b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete b;
+            }
+        }
+        static void* get(storage_type& s, bool modify) {
+            block* b = held(s);
+            if (modify && b->refs.load(std::memory_order_acquire) != 1) {
+                block* copy = new block(b->value);
+                destroy(s);
+                held(s) = b = copy;
+            }
+            return &b->value;
+        }
+        static const vtable* share(storage_type& src, storage_type& dst, bool steal) {
+            if (steal) {
+                move(src, dst);
+            } else {
+                clone(src, dst);
+            }
+            return any::holder<ValueType>::shared_table();
+        }
+        template<typename Arg>
+        static void construct(storage_type& s, Arg&& value) {
+            new (&s) block*(new block(std::forward<Arg>(value)));
+        }
+    };
 
-    public: // representation
-        ValueType held;
+    template<typename ValueType>
+    struct holder {
+        typedef typename std::conditional<
+                sizeof(ValueType) <= sizeof(storage_type)
+                    && alignof(storage_type) % alignof(ValueType) == 0
+                    && std::is_nothrow_move_constructible<ValueType>::value,
+                inline_holder<ValueType>, heap_holder<ValueType>>::type impl;
+
+        static const vtable* table() {
+            static const vtable vt = {&impl::type, &impl::clone, &impl::move, &impl::destroy,
+                    &impl::get, &impl::share};
+            return &vt;
+        }
 
-    private: // intentionally left unimplemented
-        holder& operator=(const holder&);
+        static const vtable* shared_table() {
+            typedef shared_holder<ValueType> s;
+            static const vtable vt = {&s::type, &s::clone, &s::move, &s::destroy, &s::get, &s::share};
+            return &vt;
+        }
     };
 
+private: // implementation
+    template<typename ValueType, typename Arg>
+    void construct(Arg&& value) {
+        holder<ValueType>::impl::construct(storage, std::forward<Arg>(value));
+        table = holder<ValueType>::table();
+    }
+
+    // Requires this to be empty.
+    void move_from(any& other) noexcept {
+        if (other.table) {
+            other.table->move(other.storage, storage);
+            table = other.table;
+            other.table = 0;
+        }
+    }
+
 private: // representation
     template<typename ValueType>
     friend ValueType* any_cast(any*);
 
-    placeholder* content;
+    storage_type storage;
+    const vtable* table;
 };
 
 inline void swap(any& lhs, any& rhs) {
@@ -130,18 +340,31 @@ public:
 
 template<typename ValueType>
 ValueType* any_cast(any* operand) {
-    return operand && operand->type() == typeid(ValueType) ? &static_cast<any::holder<ValueType>*>(operand->content)->held : 0;
+    typedef typename std::remove_cv<ValueType>::type value_type;
+    if (!operand || !operand->table) {
+        return 0;
+    }
+    // The vtable addresses may differ across shared libraries for the same type.
+    if (operand->table != any::holder<value_type>::table()
+            && operand->table != any::holder<value_type>::shared_table()
+            && operand->table->type() != typeid(value_type)) {
+        return 0;
+    }
+    return static_cast<ValueType*>(operand->table->get(operand->storage, !std::is_const<ValueType>::value));
 }
 
 template<typename ValueType>
 inline const ValueType* any_cast(const any* operand) {
-    return any_cast<ValueType>(const_cast<any*>(operand));
+    return any_cast<const ValueType>(const_cast<any*>(operand));
 }
 
 template<typename ValueType>
 ValueType any_cast(any& operand) {
     typedef typename std::remove_reference<ValueType>::type nonref;
-    nonref* result = any_cast<nonref>(&operand);
+    // Returning a copy needs only read access, which keeps a shared value shared.
+    typedef typename std::conditional<std::is_reference<ValueType>::value,
+            nonref, const nonref>::type accessed;
+    accessed* result = any_cast<accessed>(&operand);
     if (!result)
         throw bad_any_cast();
     return *result;
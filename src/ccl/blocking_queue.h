@@ -6,10 +6,12 @@
 #include <condition_variable>
 #include <mutex>
 #include <queue>
+#include "ccl/wait_strategy.h"
 
 namespace ccl {
 
-template<typename T>
+// WaitStrategy decides how Push and Pop wait, e.g. BlockingWait or SpinThenParkWait.
+template<typename T, typename WaitStrategy = BlockingWait>
 class BlockingQueue final {
 private:
     const size_t m_capacity;
@@ -36,9 +38,7 @@ public:
 
     void Push(const T& element) {
         std::unique_lock<std::mutex> lock(m_mutex);
-        while (isFull()) {
-            m_condition.wait(lock);
-        }
+        WaitStrategy::Wait(lock, m_condition, [this]() { return !isFull(); });
         bool wasEmpty = isEmpty();
         m_queue.push(element);
         if (wasEmpty) {
@@ -48,9 +48,7 @@ public:
 
     void Push(T&& element) {
         std::unique_lock<std::mutex> lock(m_mutex);
-        while (isFull()) {
-            m_condition.wait(lock);
-        }
+        WaitStrategy::Wait(lock, m_condition, [this]() { return !isFull(); });
         bool wasEmpty = isEmpty();
         m_queue.push(std::move(element));
         if (wasEmpty) {
@@ -61,10 +59,9 @@ public:
     template<class Rep, class Period>
     std::cv_status Push(const T& element, const std::chrono::duration<Rep, Period>& timeout) {
         std::unique_lock<std::mutex> lock(m_mutex);
-        while (isFull()) {
-            if (m_condition.wait_for(lock, timeout) == std::cv_status::timeout) {
-                return std::cv_status::timeout;
-            }
+        if (!WaitStrategy::WaitUntil(lock, m_condition, std::chrono::steady_clock::now() + timeout,
+                [this]() { return !isFull(); })) {
+            return std::cv_status::timeout;
         }
         bool wasEmpty = isEmpty();
         m_queue.push(element);
@@ -77,10 +74,9 @@ public:
     template<class Rep, class Period>
     std::cv_status Push(T&& element, const std::chrono::duration<Rep, Period>& timeout) {
         std::unique_lock<std::mutex> lock(m_mutex);
-        while (isFull()) {
-            if (m_condition.wait_for(lock, timeout) == std::cv_status::timeout) {
-                return std::cv_status::timeout;
-            }
+        if (!WaitStrategy::WaitUntil(lock, m_condition, std::chrono::steady_clock::now() + timeout,
+                [this]() { return !isFull(); })) {
+            return std::cv_status::timeout;
         }
         bool wasEmpty = isEmpty();
         m_queue.push(std::move(element));
@@ -90,13 +86,28 @@ public:
         return std::cv_status::no_timeout;
     }
 
+    // Pushes the elements in [first, last) in batches that fill the free capacity,
+    // so the lock is taken and waiters are notified once per batch rather than per element.
+    template<typename InputIt>
+    void PushAll(InputIt first, InputIt last) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (first != last) {
+            WaitStrategy::Wait(lock, m_condition, [this]() { return !isFull(); });
+            bool wasEmpty = isEmpty();
+            for (; first != last && !isFull(); ++first) {
+                m_queue.push(*first);
+            }
+            if (wasEmpty) {
+                m_condition.notify_all();
+            }
+        }
+    }
+
     T Pop() {
         T element;
         {
             std::unique_lock<std::mutex> lock(m_mutex);
-            while (isEmpty()) {
-                m_condition.wait(lock);
-            }
+            WaitStrategy::Wait(lock, m_condition, [this]() { return !isEmpty(); });
             bool wasFull = isFull();
             element = std::move(m_queue.front());
             m_queue.pop();
@@ -110,10 +121,9 @@ public:
     template<class Rep, class Period>
     std::cv_status Pop(const std::chrono::duration<Rep, Period>& timeout, T* element) {
         std::unique_lock<std::mutex> lock(m_mutex);
-        while (isEmpty()) {
-            if (m_condition.wait_for(lock, timeout) == std::cv_status::timeout) {
-                return std::cv_status::timeout;
-            }
+        if (!WaitStrategy::WaitUntil(lock, m_condition, std::chrono::steady_clock::now() + timeout,
+                [this]() { return !isEmpty(); })) {
+            return std::cv_status::timeout;
         }
         bool wasFull = isFull();
         if (element != nullptr) {
@@ -126,6 +136,32 @@ public:
         return std::cv_status::no_timeout;
     }
 
+    // Waits until the queue is not empty and moves up to maxItems elements to out.
+    // Returns the number of moved elements.
+    template<typename OutputIt>
+    size_t DrainTo(OutputIt out, size_t maxItems) {
+        if (maxItems == 0) {
+            return 0;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        WaitStrategy::Wait(lock, m_condition, [this]() { return !isEmpty(); });
+        return drain(out, maxItems);
+    }
+
+    // Returns 0 if the queue stays empty until the timeout.
+    template<typename OutputIt, class Rep, class Period>
+    size_t DrainTo(OutputIt out, size_t maxItems, const std::chrono::duration<Rep, Period>& timeout) {
+        if (maxItems == 0) {
+            return 0;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!WaitStrategy::WaitUntil(lock, m_condition, std::chrono::steady_clock::now() + timeout,
+                [this]() { return !isEmpty(); })) {
+            return 0;
+        }
+        return drain(out, maxItems);
+    }
+
     void Clear() {
         std::lock_guard<std::mutex> lock(m_mutex);
         bool wasFull = isFull();
@@ -138,6 +174,21 @@ public:
     }
 
 private:
+    template<typename OutputIt>
+    size_t drain(OutputIt& out, size_t maxItems) {
+        bool wasFull = isFull();
+        size_t n = 0;
+        for (; n < maxItems && !isEmpty(); n++) {
+            *out = std::move(m_queue.front());
+            ++out;
+            m_queue.pop();
+        }
+        if (wasFull) {
+            m_condition.notify_all();
+        }
+        return n;
+    }
+
     bool isEmpty() {
         return m_queue.empty();
     }
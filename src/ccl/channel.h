@@ -1,56 +1,321 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
 #include <condition_variable>
+#include <deque>
+#include <functional>
 #include <mutex>
+#include <utility>
+#include <vector>
+#include "ccl/wait_strategy.h"
 
 namespace ccl {
 
-template<typename T>
-class Channel final {
-private:
-    T m_message;
-    bool m_recvReady;
-    bool m_sendReady;
+// Wakes up a Select that waits on several channels.
+struct selectWaiter {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool ready;
+
+    selectWaiter() : ready(false) {}
+};
+
+class channelBase {
+protected:
     std::mutex m_mutex;
+    bool m_closed;
+    std::vector<selectWaiter*> m_selectors;
+
+public:
+    channelBase() : m_closed(false) {}
+
+    virtual ~channelBase() = default;
+
+    void Attach(selectWaiter* waiter) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_selectors.push_back(waiter);
+    }
+
+    void Detach(selectWaiter* waiter) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_selectors.erase(std::find(m_selectors.begin(), m_selectors.end(), waiter));
+    }
+
+    // Returns true if the channel is closed and has no message left.
+    virtual bool Drained() = 0;
+
+protected:
+    // Must be called with m_mutex held.
+    void notifySelectors() {
+        for (selectWaiter* waiter : m_selectors) {
+            std::lock_guard<std::mutex> lock(waiter->mutex);
+            waiter->ready = true;
+            waiter->condition.notify_one();
+        }
+    }
+};
+
+// Go-style channel.
+// With a capacity of 0 the channel is unbuffered: Send waits until a receiver
+// has taken the message. Otherwise Send only waits while capacity messages
+// are buffered, and threads are woken up only if they are actually waiting,
+// so a pipeline that keeps up does not pay for context switches per message.
+// After Close, Send fails and Receive drains the messages still buffered.
+// WaitStrategy decides how Send and Receive wait, e.g. BlockingWait or SpinThenParkWait.
+template<typename T, typename WaitStrategy = BlockingWait>
+class Channel final : public channelBase {
+private:
+    const size_t m_capacity;
+    std::deque<T> m_buffer;
+    uint64_t m_sentCount;
+    uint64_t m_receivedCount;
+    size_t m_waitingReceivers;
+    size_t m_waitingSenders;
     std::condition_variable m_recvCondition;
     std::condition_variable m_sendCondition;
 
 public:
-    Channel() : m_recvReady(false), m_sendReady(false) {}
+    explicit Channel(size_t capacity = 0)
+            : m_capacity(capacity), m_sentCount(0), m_receivedCount(0)
+            , m_waitingReceivers(0), m_waitingSenders(0) {}
 
     ~Channel() = default;
     Channel(const Channel&) = delete;
     Channel& operator=(const Channel&) = delete;
 
+    // Blocks until the message is buffered, or taken by a receiver if the
+    // channel is unbuffered. Returns false if the channel was closed before.
+    bool Send(const T& message) {
+        return send(message);
+    }
+
+    bool Send(T&& message) {
+        return send(std::move(message));
+    }
+
+    // Returns a default constructed T if the channel is closed and drained.
     T Receive() {
+        T message = T();
+        Receive(message);
+        return message;
+    }
+
+    // Blocks until a message arrives. Returns false if the channel is closed and drained.
+    bool Receive(T& message) {
         std::unique_lock<std::mutex> lock(m_mutex);
-        while (!m_sendReady) {
-            m_sendCondition.wait(lock);
+        if (m_buffer.empty() && !m_closed) {
+            m_waitingReceivers++;
+            WaitStrategy::Wait(lock, m_recvCondition, [this]() { return !m_buffer.empty() || m_closed; });
+            m_waitingReceivers--;
         }
-        m_recvReady = true;
-        m_sendReady = false;
-        m_recvCondition.notify_all();
-        return std::move(m_message);
+        if (m_buffer.empty()) {
+            return false;
+        }
+        pop(message);
+        return true;
     }
 
-    void Send(const T& message) {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_message = message;
-        m_recvReady = false;
-        m_sendReady = true;
-        m_sendCondition.notify_all();
-        while (!m_recvReady) {
-            m_recvCondition.wait(lock);
+    // Returns false without blocking if no message is available.
+    bool TryReceive(T& message) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_buffer.empty()) {
+            return false;
         }
+        pop(message);
+        return true;
+    }
+
+    // Makes the blocked and later senders fail, and the receivers fail once
+    // the buffered messages have been received.
+    void Close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed) {
+            return;
+        }
+        m_closed = true;
+        m_recvCondition.notify_all();
+        m_sendCondition.notify_all();
+        notifySelectors();
+    }
+
+    bool IsClosed() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_closed;
+    }
+
+    bool Drained() override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_closed && m_buffer.empty();
+    }
+
+    size_t Capacity() const {
+        return m_capacity;
     }
 
     void operator>>(T& message) {
-        message = Receive();
+        Receive(message);
     }
 
     void operator<<(const T& message) {
         Send(message);
     }
+
+    void operator<<(T&& message) {
+        Send(std::move(message));
+    }
+
+private:
+    template<typename U>
+    bool send(U&& message) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        size_t limit = m_capacity != 0 ? m_capacity : 1;
+        waitForReceiver(lock, [this, limit]() { return m_buffer.size() < limit || m_closed; });
+        if (m_closed) {
+            return false;
+        }
+        m_buffer.push_back(std::forward<U>(message));
+        uint64_t sequence = ++m_sentCount;
+        if (m_waitingReceivers > 0) {
+            m_recvCondition.notify_one();
+        }
+        notifySelectors();
+        if (m_capacity == 0) {
+            // Once closed, the message may still be received but nobody is waited for.
+            waitForReceiver(lock, [this, sequence]() { return m_receivedCount >= sequence || m_closed; });
+        }
+        return true;
+    }
+
+    template<typename Predicate>
+    void waitForReceiver(std::unique_lock<std::mutex>& lock, Predicate pred) {
+        if (pred()) {
+            return;
+        }
+        m_waitingSenders++;
+        WaitStrategy::Wait(lock, m_sendCondition, pred);
+        m_waitingSenders--;
+    }
+
+    void pop(T& message) {
+        message = std::move(m_buffer.front());
+        m_buffer.pop_front();
+        m_receivedCount++;
+        if (m_waitingSenders > 0) {
+            // An unbuffered channel has senders waiting for the hand-over and
+            // for the slot, so all of them check whether it was theirs.
+            if (m_capacity == 0) {
+                m_sendCondition.notify_all();
+            } else {
+                m_sendCondition.notify_one();
+            }
+        }
+    }
+};
+
+// Receives from whichever of several channels has a message first, like
+// Go's select statement. The cases are registered once and Wait can be called
+// repeatedly, e.g.
+//
+//     Select select;
+//     select.Case(numbers, [](int n) { ... })
+//           .Case(names, [](std::string name) { ... });
+//     while (select.Wait()) {}
+//
+// Wait sleeps until one of the channels gets a message or is closed, and runs
+// the handler of the channel outside of its lock. When several channels are
+// ready, the cases take turns. Wait returns false once every channel is
+// closed and drained. The channels must outlive the Select.
+class Select final {
+private:
+    struct selectCase {
+        channelBase* channel;
+        std::function<bool()> receive; // receives a message and runs the handler, or returns false
+    };
+
+    std::vector<selectCase> m_cases;
+    selectWaiter m_waiter;
+    size_t m_next; // the case to try first
+
+public:
+    Select() : m_next(0) {}
+
+    ~Select() = default;
+    Select(const Select&) = delete;
+    Select& operator=(const Select&) = delete;
+
+    template<typename T, typename WaitStrategy, typename Handler>
+    Select& Case(Channel<T, WaitStrategy>& channel, Handler handler) {
+        Channel<T, WaitStrategy>* chan = &channel;
+        m_cases.push_back(selectCase{chan, [chan, handler]() mutable {
+            T message = T();
+            if (!chan->TryReceive(message)) {
+                return false;
+            }
+            handler(std::move(message));
+            return true;
+        }});
+        return *this;
+    }
+
+    bool Wait() {
+        if (tryReceive()) {
+            return true;
+        }
+        for (auto& c : m_cases) {
+            c.channel->Attach(&m_waiter);
+        }
+        bool received = false;
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(m_waiter.mutex);
+                m_waiter.ready = false;
+            }
+            if (tryReceive()) {
+                received = true;
+                break;
+            }
+            if (drained()) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(m_waiter.mutex);
+            while (!m_waiter.ready) {
+                m_waiter.condition.wait(lock);
+            }
+        }
+        for (auto& c : m_cases) {
+            c.channel->Detach(&m_waiter);
+        }
+        return received;
+    }
+
+    // Returns false without blocking if no channel has a message.
+    bool TryWait() {
+        return tryReceive();
+    }
+
+private:
+    bool tryReceive() {
+        size_t n = m_cases.size();
+        for (size_t i = 0; i < n; i++) {
+            size_t index = (m_next + i) % n;
+            if (m_cases[index].receive()) {
+                m_next = (index + 1) % n;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool drained() {
+        for (auto& c : m_cases) {
+            if (!c.channel->Drained()) {
+                return false;
+            }
+        }
+        return true;
+    }
 };
 
 } // namespace ccl
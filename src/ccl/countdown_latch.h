@@ -1,56 +1,109 @@
 #pragma once
 
+#include <cstdint>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <thread>
+#include "ccl/wait_strategy.h"
 
 namespace ccl {
 
-class CountdownLatch final {
+// CountDown is a single atomic operation. Only the call that brings the
+// count to 0 takes the mutex, and only if a thread is waiting in Await.
+// WaitStrategy decides how Await waits, e.g. BlockingWait or SpinThenParkWait.
+template<typename WaitStrategy = BlockingWait>
+class BasicCountdownLatch final {
 private:
-    unsigned int m_count;
+    // The state holds the count in the low bits. The waking bit is set while
+    // the CountDown that reached 0 still notifies the waiters, so that the
+    // destructor can wait for it.
+    static const uint64_t kCountMask = 0xffffffff;
+    static const uint64_t kWakingBit = uint64_t(1) << 32;
+
+    std::atomic<uint64_t> m_state;
+    std::atomic<unsigned int> m_waiters;
     std::mutex m_mutex;
     std::condition_variable m_condition;
 
 public:
-    CountdownLatch(unsigned int count = 1) : m_count(count) {}
+    BasicCountdownLatch(unsigned int count = 1) : m_state(count), m_waiters(0) {}
 
-    ~CountdownLatch() = default;
-    CountdownLatch(const CountdownLatch&) = delete;
-    CountdownLatch& operator=(const CountdownLatch&) = delete;
+    ~BasicCountdownLatch() {
+        while (m_state.load(std::memory_order_acquire) & kWakingBit) {
+            std::this_thread::yield();
+        }
+    }
+
+    BasicCountdownLatch(const BasicCountdownLatch&) = delete;
+    BasicCountdownLatch& operator=(const BasicCountdownLatch&) = delete;
 
     void Await() {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        while (m_count > 0) {
-            m_condition.wait(lock);
+        if (isZero()) {
+            return;
         }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_waiters.fetch_add(1);
+        auto zero = [this]() { return isZero(); }; // also safe without the lock
+        WaitStrategy::Wait(lock, m_condition, zero, zero);
+        m_waiters.fetch_sub(1);
     }
 
     template<class Rep, class Period>
     std::cv_status Await(const std::chrono::duration<Rep, Period>& timeout) {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        while (m_count > 0) {
-            if (m_condition.wait_for(lock, timeout) == std::cv_status::timeout) {
-                return std::cv_status::timeout;
-            }
+        if (isZero()) {
+            return std::cv_status::no_timeout;
         }
-        return std::cv_status::no_timeout;
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_waiters.fetch_add(1);
+        auto zero = [this]() { return isZero(); }; // also safe without the lock
+        bool reached = WaitStrategy::WaitUntil(lock, m_condition, deadline, zero, zero);
+        m_waiters.fetch_sub(1);
+        return reached ? std::cv_status::no_timeout : std::cv_status::timeout;
     }
 
     void CountDown() {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_count == 0) {
+        CountDown(1);
+    }
+
+    // Decrements the count by n at once, stopping at 0.
+    void CountDown(unsigned int n) {
+        if (n == 0) {
+            return;
+        }
+        uint64_t state = m_state.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            if ((state & kCountMask) == 0) {
+                return;
+            }
+            next = state > n ? state - n : kWakingBit;
+        } while (!m_state.compare_exchange_weak(state, next));
+        if (next != kWakingBit) {
             return;
         }
-        m_count--;
-        if (m_count == 0) {
+        // A waiter registers before it checks the count, so either it sees 0
+        // or it is seen here. It holds the mutex from the check until it
+        // sleeps, so locking the mutex here cannot miss it.
+        if (m_waiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
             m_condition.notify_all();
         }
+        m_state.store(0, std::memory_order_release); // the last access to the latch
     }
 
-    unsigned int GetCount() {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_count;
+    unsigned int GetCount() const {
+        return static_cast<unsigned int>(m_state.load(std::memory_order_relaxed) & kCountMask);
+    }
+
+private:
+    bool isZero() const {
+        return (m_state.load() & kCountMask) == 0;
     }
 };
 
+using CountdownLatch = BasicCountdownLatch<>;
+
 } // namespace ccl
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include "ccl/wait_strategy.h"
+
+namespace ccl {
+
+// Makes a fixed number of parties wait for each other, phase after phase.
+// Unlike CountdownLatch it resets itself once all parties have arrived, so
+// iterative jobs use one barrier for all phases.
+// The barrier is sense-reversing: an arriving thread decrements one atomic
+// counter and waits for the generation to change. The last one to arrive runs
+// the completion callback, resets the counter and bumps the generation, and
+// takes the mutex only if a thread is parked.
+// WaitStrategy decides how Await waits, e.g. BlockingWait or SpinThenParkWait.
+template<typename WaitStrategy = BlockingWait>
+class BasicCyclicBarrier final {
+private:
+    const unsigned int m_parties;
+    const std::function<void()> m_completion;
+    std::atomic<unsigned int> m_remaining;
+    std::atomic<uint64_t> m_generation;
+    std::atomic<unsigned int> m_waiters;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+
+public:
+    // completion runs on the last arriving thread before the others are released.
+    // If it throws, the phase still advances, so that the other parties are
+    // released and the barrier stays usable, and the exception propagates
+    // from the Await of the last thread.
+    explicit BasicCyclicBarrier(unsigned int parties, std::function<void()> completion = nullptr)
+            : m_parties(parties), m_completion(std::move(completion))
+            , m_remaining(parties), m_generation(0), m_waiters(0) {}
+
+    ~BasicCyclicBarrier() = default;
+    BasicCyclicBarrier(const BasicCyclicBarrier&) = delete;
+    BasicCyclicBarrier& operator=(const BasicCyclicBarrier&) = delete;
+
+    // Blocks until all parties have arrived. Returns the arrival index:
+    // parties - 1 for the first thread to arrive and 0 for the last one.
+    unsigned int Await() {
+        uint64_t generation = m_generation.load(std::memory_order_acquire);
+        unsigned int index = m_remaining.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        if (index == 0) {
+            try {
+                if (m_completion) {
+                    m_completion();
+                }
+            } catch (...) {
+                advance(generation);
+                throw;
+            }
+            advance(generation);
+            return 0;
+        }
+        auto advanced = [this, generation]() { return m_generation.load() != generation; };
+        if (!advanced()) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_waiters.fetch_add(1);
+            WaitStrategy::Wait(lock, m_condition, advanced, advanced);
+            m_waiters.fetch_sub(1);
+        }
+        return index;
+    }
+
+    unsigned int GetParties() const {
+        return m_parties;
+    }
+
+    // Returns the number of completed phases.
+    uint64_t GetGeneration() const {
+        return m_generation.load(std::memory_order_relaxed);
+    }
+
+private:
+    void advance(uint64_t generation) {
+        m_remaining.store(m_parties, std::memory_order_relaxed);
+        m_generation.store(generation + 1);
+        if (m_waiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_condition.notify_all();
+        }
+    }
+};
+
+using CyclicBarrier = BasicCyclicBarrier<>;
+
+} // namespace ccl
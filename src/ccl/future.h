@@ -0,0 +1,580 @@
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ccl/task.h"
+
+namespace ccl {
+
+template<typename T>
+class Future;
+
+template<typename T>
+class Promise;
+
+template<typename R>
+struct futureResult;
+
+template<typename T>
+struct futureInvoker;
+
+// Holds the value of a completed future, if any.
+template<typename T>
+class futureValue final {
+private:
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+    bool m_constructed;
+
+public:
+    futureValue() : m_constructed(false) {}
+
+    ~futureValue() {
+        if (m_constructed) {
+            get().~T();
+        }
+    }
+
+    futureValue(const futureValue&) = delete;
+    futureValue& operator=(const futureValue&) = delete;
+
+    template<typename... Args>
+    void Set(Args&&... args) {
+        new (&m_storage) T(std::forward<Args>(args)...);
+        m_constructed = true;
+    }
+
+    T Take() {
+        return std::move(get());
+    }
+
+private:
+    T& get() {
+        return *reinterpret_cast<T*>(&m_storage);
+    }
+};
+
+template<>
+class futureValue<void> final {
+public:
+    void Set() {}
+    void Take() {}
+};
+
+// The state shared by a Promise and its Future, allocated once.
+// Completing it and attaching the continuation are each a single atomic
+// fetch_or, so whichever comes second runs the continuation, without a lock.
+// The mutex and condition variable are only used by threads that block in Wait.
+template<typename T>
+class futureState final {
+private:
+    static const int kResult = 1;
+    static const int kCallback = 2;
+
+    std::atomic<int> m_flags;
+    std::atomic<bool> m_satisfied;
+    std::atomic<unsigned int> m_waiters;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    futureValue<T> m_value;
+    std::exception_ptr m_exception;
+    Task m_callback;
+
+public:
+    futureState() : m_flags(0), m_satisfied(false), m_waiters(0) {}
+
+    futureState(const futureState&) = delete;
+    futureState& operator=(const futureState&) = delete;
+
+    // Returns true only for the first caller, which then completes the state.
+    bool TrySatisfy() {
+        return !m_satisfied.exchange(true);
+    }
+
+    template<typename... Args>
+    void SetValue(Args&&... args) {
+        m_value.Set(std::forward<Args>(args)...);
+        complete();
+    }
+
+    void SetException(std::exception_ptr exception) {
+        m_exception = exception;
+        complete();
+    }
+
+    // Runs the callback once the state completes, on the completing thread,
+    // or right away if it already has. At most one callback can be set.
+    void SetCallback(Task&& callback) {
+        m_callback = std::move(callback);
+        if (m_flags.fetch_or(kCallback) & kResult) {
+            runCallback();
+        }
+    }
+
+    bool IsReady() const {
+        return (m_flags.load() & kResult) != 0;
+    }
+
+    void Wait() {
+        if (IsReady()) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_waiters.fetch_add(1);
+        m_condition.wait(lock, [this]() { return IsReady(); });
+        m_waiters.fetch_sub(1);
+    }
+
+    template<class Clock, class Duration>
+    bool WaitUntil(const std::chrono::time_point<Clock, Duration>& deadline) {
+        if (IsReady()) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_waiters.fetch_add(1);
+        bool ready = m_condition.wait_until(lock, deadline, [this]() { return IsReady(); });
+        m_waiters.fetch_sub(1);
+        return ready;
+    }
+
+    // Returns the value or throws the exception. Must be called once, after completion.
+    T Take() {
+        if (m_exception) {
+            std::rethrow_exception(m_exception);
+        }
+        return m_value.Take();
+    }
+
+private:
+    void complete() {
+        int flags = m_flags.fetch_or(kResult);
+        // A waiter registers before it checks the flags, see CountdownLatch.
+        if (m_waiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_condition.notify_all();
+        }
+        if (flags & kCallback) {
+            runCallback();
+        }
+    }
+
+    void runCallback() {
+        Task callback = std::move(m_callback); // breaks the cycle if it holds this state
+        callback();
+    }
+};
+
+// Selects how a continuation is run.
+struct inlineDispatch {
+    void operator()(Task&& task) const {
+        task();
+    }
+};
+
+template<typename Executor>
+struct executorDispatch {
+    std::shared_ptr<Executor> executor;
+
+    void operator()(Task&& task) const {
+        executor->Dispatch(std::move(task)); // a rejected task breaks its promise
+    }
+};
+
+// The type of the future that Then returns for a continuation returning R.
+// A continuation returning a Future is unwrapped.
+template<typename R>
+struct futureOf {
+    typedef R value_type;
+};
+
+template<typename U>
+struct futureOf<Future<U>> {
+    typedef U value_type;
+};
+
+template<typename F, typename T>
+struct continuationResult {
+    typedef typename std::result_of<F(T)>::type type;
+};
+
+template<typename F>
+struct continuationResult<F, void> {
+    typedef typename std::result_of<F()>::type type;
+};
+
+// Passes the value through, to forward a future to a promise.
+struct futureIdentity {
+    template<typename U>
+    U operator()(U&& value) const {
+        return std::forward<U>(value);
+    }
+
+    void operator()() const {}
+};
+
+// The consumer side of a Promise, like std::future, whose result can also be
+// consumed without blocking by attaching a continuation with Then.
+// A Future is move-only and consumed by Get, Then or OnComplete.
+template<typename T>
+class Future final {
+private:
+    std::shared_ptr<futureState<T>> m_state;
+
+    template<typename>
+    friend class Future;
+    template<typename>
+    friend class Promise;
+    template<typename>
+    friend struct futureResult;
+
+    explicit Future(std::shared_ptr<futureState<T>> state) : m_state(std::move(state)) {}
+
+public:
+    Future() = default;
+    ~Future() = default;
+    Future(Future&&) = default;
+    Future& operator=(Future&&) = default;
+    Future(const Future&) = delete;
+    Future& operator=(const Future&) = delete;
+
+    // Returns false if the future was default constructed or consumed.
+    bool Valid() const {
+        return m_state != nullptr;
+    }
+
+    bool IsReady() const {
+        return state()->IsReady();
+    }
+
+    void Wait() const {
+        state()->Wait();
+    }
+
+    // Returns false if the future is not ready after the timeout.
+    template<class Rep, class Period>
+    bool WaitFor(const std::chrono::duration<Rep, Period>& timeout) const {
+        return state()->WaitUntil(std::chrono::steady_clock::now() + timeout);
+    }
+
+    // Blocks until the future is ready, and returns the value or throws the exception.
+    T Get() {
+        std::shared_ptr<futureState<T>> s = std::move(state());
+        s->Wait();
+        return s->Take();
+    }
+
+    // Calls f with this future once it is ready, on the thread that completes
+    // it, or right away if it is ready already. f takes a Future<T> and
+    // receives the value or the exception by calling Get.
+    template<typename F>
+    void OnComplete(F f) {
+        std::shared_ptr<futureState<T>> s = std::move(state());
+        s->SetCallback(Task(readyCallback<F>{s, std::move(f)}));
+    }
+
+    // Returns a future of f(value), with f run inline on the thread that
+    // completes this future, or right away if it is ready already. Only cheap
+    // continuations should run inline, since they delay that thread.
+    // If this future fails, f is skipped and the exception is passed on, as
+    // is an exception thrown by f. A Future returned by f is unwrapped.
+    template<typename F>
+    Future<typename futureOf<typename continuationResult<F, T>::type>::value_type> Then(F f) {
+        return then(inlineDispatch(), std::move(f));
+    }
+
+    // The same as Then(f), but runs f with executor->Dispatch, e.g. on a
+    // ThreadPool. If the executor rejects it, the returned future fails with
+    // std::future_errc::broken_promise.
+    template<typename Executor, typename F>
+    Future<typename futureOf<typename continuationResult<F, T>::type>::value_type> Then(
+            const std::shared_ptr<Executor>& executor, F f) {
+        return then(executorDispatch<Executor>{executor}, std::move(f));
+    }
+
+private:
+    template<typename F>
+    struct readyCallback {
+        std::shared_ptr<futureState<T>> state;
+        F f;
+
+        void operator()() {
+            f(Future<T>(std::move(state)));
+        }
+    };
+
+    template<typename R, typename V, typename F>
+    struct continuation {
+        Future<T> ready;
+        Promise<V> promise;
+        F f;
+
+        void operator()() {
+            try {
+                futureInvoker<T>::template Run<R>(ready, promise, f);
+            } catch (...) {
+                promise.SetException(std::current_exception());
+            }
+        }
+    };
+
+    template<typename R, typename V, typename F, typename Dispatch>
+    struct dispatcher {
+        Promise<V> promise;
+        F f;
+        Dispatch dispatch;
+
+        void operator()(Future<T> ready) {
+            dispatch(Task(continuation<R, V, F>{std::move(ready), std::move(promise), std::move(f)}));
+        }
+    };
+
+    template<typename Dispatch, typename F>
+    Future<typename futureOf<typename continuationResult<F, T>::type>::value_type> then(Dispatch dispatch, F f) {
+        typedef typename continuationResult<F, T>::type R;
+        typedef typename futureOf<R>::value_type V;
+        state(); // throws before anything is allocated
+        Promise<V> promise;
+        Future<V> next = promise.GetFuture();
+        OnComplete(dispatcher<R, V, F, Dispatch>{std::move(promise), std::move(f), std::move(dispatch)});
+        return next;
+    }
+
+    // Completes the promise with the result of this future.
+    void forwardTo(Promise<T>&& promise) {
+        if (!m_state) {
+            promise.SetException(std::make_exception_ptr(std::future_error(std::future_errc::no_state)));
+            return;
+        }
+        OnComplete(forwarder{std::move(promise)});
+    }
+
+    struct forwarder {
+        Promise<T> promise;
+
+        void operator()(Future<T> ready) {
+            try {
+                futureIdentity f;
+                futureInvoker<T>::template Run<T>(ready, promise, f);
+            } catch (...) {
+                promise.SetException(std::current_exception());
+            }
+        }
+    };
+
+    std::shared_ptr<futureState<T>>& state() {
+        if (!m_state) {
+            throw std::future_error(std::future_errc::no_state);
+        }
+        return m_state;
+    }
+
+    const std::shared_ptr<futureState<T>>& state() const {
+        if (!m_state) {
+            throw std::future_error(std::future_errc::no_state);
+        }
+        return m_state;
+    }
+
+};
+
+// The producer side of a Future, like std::promise.
+// The shared state is allocated by the first GetFuture, SetValue or
+// SetException, so a promise that is never used costs nothing. The result
+// may be set before the future is retrieved.
+// A promise destroyed without a result fails its future with
+// std::future_errc::broken_promise.
+template<typename T>
+class Promise final {
+private:
+    std::shared_ptr<futureState<T>> m_state; // allocated by the first GetFuture, SetValue or SetException
+    bool m_retrieved;
+
+public:
+    Promise() noexcept : m_retrieved(false) {}
+
+    ~Promise() {
+        if (m_state && m_state->TrySatisfy()) {
+            m_state->SetException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+    }
+
+    Promise(Promise&& other) noexcept : m_state(std::move(other.m_state)), m_retrieved(other.m_retrieved) {
+        other.m_retrieved = false;
+    }
+
+    Promise& operator=(Promise&& other) noexcept {
+        Promise(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    Promise(const Promise&) = delete;
+    Promise& operator=(const Promise&) = delete;
+
+    void swap(Promise& other) noexcept {
+        m_state.swap(other.m_state);
+        std::swap(m_retrieved, other.m_retrieved);
+    }
+
+    // Throws std::future_error if called twice.
+    Future<T> GetFuture() {
+        if (m_retrieved) {
+            throw std::future_error(std::future_errc::future_already_retrieved);
+        }
+        m_retrieved = true;
+        return Future<T>(state());
+    }
+
+    // Throws std::future_error if the result was already set.
+    template<typename... Args>
+    void SetValue(Args&&... args) {
+        if (!state()->TrySatisfy()) {
+            throw std::future_error(std::future_errc::promise_already_satisfied);
+        }
+        m_state->SetValue(std::forward<Args>(args)...);
+    }
+
+    // Throws std::future_error if the result was already set.
+    void SetException(std::exception_ptr exception) {
+        if (!state()->TrySatisfy()) {
+            throw std::future_error(std::future_errc::promise_already_satisfied);
+        }
+        m_state->SetException(exception);
+    }
+
+private:
+    const std::shared_ptr<futureState<T>>& state() {
+        if (!m_state) {
+            m_state = std::make_shared<futureState<T>>();
+        }
+        return m_state;
+    }
+};
+
+// Sets the promise from the result of f(args...).
+template<typename R>
+struct futureResult {
+    template<typename F, typename... Args>
+    static void Set(Promise<R>& promise, F& f, Args&&... args) {
+        promise.SetValue(f(std::forward<Args>(args)...));
+    }
+};
+
+template<>
+struct futureResult<void> {
+    template<typename F, typename... Args>
+    static void Set(Promise<void>& promise, F& f, Args&&... args) {
+        f(std::forward<Args>(args)...);
+        promise.SetValue();
+    }
+};
+
+template<typename U>
+struct futureResult<Future<U>> {
+    template<typename F, typename... Args>
+    static void Set(Promise<U>& promise, F& f, Args&&... args) {
+        f(std::forward<Args>(args)...).forwardTo(std::move(promise));
+    }
+};
+
+
+// Calls f with the value of a ready future.
+template<typename T>
+struct futureInvoker {
+    template<typename R, typename F, typename V>
+    static void Run(Future<T>& ready, Promise<V>& promise, F& f) {
+        futureResult<R>::Set(promise, f, ready.Get());
+    }
+};
+
+template<>
+struct futureInvoker<void> {
+    template<typename R, typename F, typename V>
+    static void Run(Future<void>& ready, Promise<V>& promise, F& f) {
+        ready.Get();
+        futureResult<R>::Set(promise, f);
+    }
+};
+
+// Returns a future of the values of all the futures, in their order, or of
+// the first exception among them.
+template<typename T>
+Future<std::vector<T>> WhenAll(std::vector<Future<T>> futures) {
+    static_assert(!std::is_void<T>::value, "WhenAll needs futures with values");
+
+    struct context {
+        std::vector<futureValue<T>> values;
+        std::atomic<size_t> remaining;
+        std::atomic<bool> failed;
+        Promise<std::vector<T>> promise;
+
+        explicit context(size_t n) : values(n), remaining(n), failed(false) {}
+    };
+
+    auto ctx = std::make_shared<context>(futures.size());
+    Future<std::vector<T>> all = ctx->promise.GetFuture();
+    if (futures.empty()) {
+        ctx->promise.SetValue();
+        return all;
+    }
+    for (size_t i = 0; i < futures.size(); i++) {
+        futures[i].OnComplete([ctx, i](Future<T> ready) {
+            try {
+                ctx->values[i].Set(ready.Get());
+            } catch (...) {
+                if (!ctx->failed.exchange(true)) {
+                    ctx->promise.SetException(std::current_exception());
+                }
+            }
+            if (ctx->remaining.fetch_sub(1) == 1 && !ctx->failed.load()) {
+                std::vector<T> values;
+                values.reserve(ctx->values.size());
+                for (auto& value : ctx->values) {
+                    values.push_back(value.Take());
+                }
+                ctx->promise.SetValue(std::move(values));
+            }
+        });
+    }
+    return all;
+}
+
+// Returns a future of the index and the value of whichever future completes
+// first, or of its exception. The futures must not be empty.
+template<typename T>
+Future<std::pair<size_t, T>> WhenAny(std::vector<Future<T>> futures) {
+    static_assert(!std::is_void<T>::value, "WhenAny needs futures with values");
+
+    struct context {
+        std::atomic<bool> done;
+        Promise<std::pair<size_t, T>> promise;
+
+        context() : done(false) {}
+    };
+
+    auto ctx = std::make_shared<context>();
+    Future<std::pair<size_t, T>> any = ctx->promise.GetFuture();
+    for (size_t i = 0; i < futures.size(); i++) {
+        futures[i].OnComplete([ctx, i](Future<T> ready) {
+            if (ctx->done.exchange(true)) {
+                return;
+            }
+            try {
+                ctx->promise.SetValue(i, ready.Get());
+            } catch (...) {
+                ctx->promise.SetException(std::current_exception());
+            }
+        });
+    }
+    return any;
+}
+
+} // namespace ccl
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+namespace ccl {
+
+// A histogram of non-negative values, e.g. durations in nanoseconds, in
+// power-of-two buckets: bucket 0 counts the value 0 and bucket i counts the
+// values in [2^(i-1), 2^i). Recording is a few instructions and the size is
+// fixed, at the cost of percentiles that are only exact to a factor of 2.
+class Histogram final {
+public:
+    static const size_t kBucketCount = 65;
+
+private:
+    uint64_t m_buckets[kBucketCount];
+    uint64_t m_count;
+    uint64_t m_sum;
+
+public:
+    Histogram() : m_buckets(), m_count(0), m_sum(0) {}
+
+    void Record(uint64_t value) {
+        m_buckets[BucketOf(value)]++;
+        m_count++;
+        m_sum += value;
+    }
+
+    void Merge(const Histogram& other) {
+        for (size_t i = 0; i < kBucketCount; i++) {
+            m_buckets[i] += other.m_buckets[i];
+        }
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+    }
+
+    uint64_t Count() const {
+        return m_count;
+    }
+
+    uint64_t Sum() const {
+        return m_sum;
+    }
+
+    double Mean() const {
+        return m_count != 0 ? static_cast<double>(m_sum) / m_count : 0;
+    }
+
+    uint64_t Bucket(size_t index) const {
+        return m_buckets[index];
+    }
+
+    // Returns the upper bound of the bucket holding the p-th percentile,
+    // where p is in [0, 1], or 0 if the histogram is empty.
+    uint64_t Percentile(double p) const {
+        uint64_t rank = static_cast<uint64_t>(p * m_count);
+        uint64_t counted = 0;
+        for (size_t i = 0; i < kBucketCount; i++) {
+            counted += m_buckets[i];
+            if (counted > rank || (counted == m_count && m_buckets[i] != 0)) {
+                return UpperBound(i);
+            }
+        }
+        return 0;
+    }
+
+    static size_t BucketOf(uint64_t value) {
+        if (value == 0) {
+            return 0;
+        }
+#if defined(__GNUC__)
+        return 64 - __builtin_clzll(value);
+#else
+        size_t bucket = 0;
+        while (value != 0) {
+            value >>= 1;
+            bucket++;
+        }
+        return bucket;
+#endif
+    }
+
+    static uint64_t UpperBound(size_t bucket) {
+        return bucket < 64 ? (uint64_t(1) << bucket) - 1 : UINT64_MAX;
+    }
+
+    friend class AtomicHistogram;
+};
+
+// A Histogram written by one thread and read by any thread at any time.
+// Recording uses relaxed loads and stores instead of read-modify-write
+// operations, so it costs about as much as Histogram::Record. A concurrent
+// reader may see the buckets, count and sum of slightly different moments.
+class AtomicHistogram final {
+private:
+    std::atomic<uint64_t> m_buckets[Histogram::kBucketCount];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+
+public:
+    AtomicHistogram() : m_count(0), m_sum(0) {
+        for (auto& bucket : m_buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    AtomicHistogram(const AtomicHistogram&) = delete;
+    AtomicHistogram& operator=(const AtomicHistogram&) = delete;
+
+    // Must only be called by the owning thread.
+    void Record(uint64_t value) {
+        increment(m_buckets[Histogram::BucketOf(value)], 1);
+        increment(m_count, 1);
+        increment(m_sum, value);
+    }
+
+    // Adds the current values to the histogram.
+    void AddTo(Histogram* histogram) const {
+        for (size_t i = 0; i < Histogram::kBucketCount; i++) {
+            histogram->m_buckets[i] += m_buckets[i].load(std::memory_order_relaxed);
+        }
+        histogram->m_count += m_count.load(std::memory_order_relaxed);
+        histogram->m_sum += m_sum.load(std::memory_order_relaxed);
+    }
+
+private:
+    static void increment(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+} // namespace ccl
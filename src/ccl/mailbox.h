@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ccl {
+
+// Unbounded lock-free multi-producer single-consumer queue (Vyukov's node queue).
+// Any thread may call Push. Only one thread at a time may call Pop.
+// A Push that is still in progress may not be visible to Pop yet, but it
+// already makes Empty return false, which any thread may call.
+// Popped nodes are kept for later pushes, up to kMaxSpareNodes, so that a
+// mailbox which is drained as fast as it is filled does not allocate.
+template<typename T>
+class Mailbox final {
+private:
+    static const size_t kMaxSpareNodes = 1024;
+
+    struct node {
+        std::atomic<node*> next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        node() : next(nullptr) {}
+
+        T& value() {
+            return *reinterpret_cast<T*>(&storage);
+        }
+    };
+
+    std::atomic<node*> m_head; // the last pushed node
+    std::atomic<node*> m_tail; // the stub node, whose value has already been popped
+    // Stack of spare nodes, linked by next. Pop pushes onto it, and Push takes
+    // a node only while holding m_spareLock, so a node cannot be taken and
+    // returned between reading the top and swapping it out (no ABA problem).
+    // A Push that finds the lock held allocates instead of waiting.
+    std::atomic<node*> m_spare;
+    std::atomic<size_t> m_spareCount;
+    std::atomic_flag m_spareLock;
+
+public:
+    Mailbox() : m_head(new node()), m_tail(m_head.load(std::memory_order_relaxed)), m_spare(nullptr)
+            , m_spareCount(0) {
+        m_spareLock.clear();
+    }
+
+    ~Mailbox() {
+        node* n = m_tail.load(std::memory_order_relaxed);
+        node* next = n->next.load(std::memory_order_relaxed);
+        delete n;
+        while (next != nullptr) {
+            n = next;
+            next = n->next.load(std::memory_order_relaxed);
+            n->value().~T();
+            delete n;
+        }
+        for (node* spare = m_spare.load(std::memory_order_relaxed); spare != nullptr; spare = next) {
+            next = spare->next.load(std::memory_order_relaxed);
+            delete spare;
+        }
+    }
+
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    bool Empty() const {
+        return m_head.load() == m_tail.load(std::memory_order_relaxed);
+    }
+
+    void Push(const T& element) {
+        node* n = takeNode();
+        new (&n->storage) T(element);
+        link(n);
+    }
+
+    void Push(T&& element) {
+        node* n = takeNode();
+        new (&n->storage) T(std::move(element));
+        link(n);
+    }
+
+    // Returns false if no element is visible.
+    bool Pop(T* element) {
+        node* tail = m_tail.load(std::memory_order_relaxed);
+        node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+        *element = std::move(next->value());
+        next->value().~T();
+        m_tail.store(next, std::memory_order_relaxed);
+        recycle(tail);
+        return true;
+    }
+
+private:
+    node* takeNode() {
+        if (m_spare.load(std::memory_order_relaxed) != nullptr
+                && !m_spareLock.test_and_set(std::memory_order_acquire)) {
+            node* n = m_spare.load(std::memory_order_acquire);
+            while (n != nullptr && !m_spare.compare_exchange_weak(n, n->next.load(std::memory_order_relaxed),
+                    std::memory_order_acquire)) {
+            }
+            m_spareLock.clear(std::memory_order_release);
+            if (n != nullptr) {
+                m_spareCount.fetch_sub(1, std::memory_order_relaxed);
+                n->next.store(nullptr, std::memory_order_relaxed);
+                return n;
+            }
+        }
+        return new node();
+    }
+
+    // Called by the consumer only.
+    void recycle(node* n) {
+        if (m_spareCount.load(std::memory_order_relaxed) >= kMaxSpareNodes) {
+            delete n;
+            return;
+        }
+        m_spareCount.fetch_add(1, std::memory_order_relaxed);
+        node* top = m_spare.load(std::memory_order_relaxed);
+        do {
+            n->next.store(top, std::memory_order_relaxed);
+        } while (!m_spare.compare_exchange_weak(top, n, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    void link(node* n) {
+        node* prev = m_head.exchange(n);
+        prev->next.store(n, std::memory_order_release);
+    }
+};
+
+} // namespace ccl
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include "ccl/wait_strategy.h"
+
+namespace ccl {
+
+// A reusable barrier whose parties can register and deregister between and
+// during phases, like java.util.concurrent.Phaser.
+// The phase, the number of parties and the number of parties yet to arrive
+// are packed into one atomic word, so registering, arriving and advancing to
+// the next phase are each a single compare-and-swap. Up to 65535 parties;
+// registering more throws std::length_error.
+// WaitStrategy decides how waiting threads wait, e.g. BlockingWait or SpinThenParkWait.
+template<typename WaitStrategy = BlockingWait>
+class BasicPhaser final {
+private:
+    // state: phase (32 bits) | parties (16 bits) | unarrived (16 bits)
+    static const int kPhaseShift = 32;
+    static const int kPartiesShift = 16;
+    static const uint64_t kPartyMask = 0xffff;
+
+    std::atomic<uint64_t> m_state;
+    std::atomic<unsigned int> m_waiters;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+
+public:
+    explicit BasicPhaser(unsigned int parties = 0)
+            : m_state(pack(0, checkParties(0, parties), parties)), m_waiters(0) {}
+
+    ~BasicPhaser() = default;
+    BasicPhaser(const BasicPhaser&) = delete;
+    BasicPhaser& operator=(const BasicPhaser&) = delete;
+
+    // Adds parties that take part from the current phase on. Returns the current phase.
+    uint32_t Register(unsigned int parties = 1) {
+        uint64_t state = m_state.load(std::memory_order_relaxed);
+        do {
+            checkParties(partiesOf(state), parties);
+        } while (!m_state.compare_exchange_weak(state,
+                pack(phaseOf(state), partiesOf(state) + parties, unarrivedOf(state) + parties)));
+        return phaseOf(state);
+    }
+
+    // Arrives without waiting for the others. Returns the phase arrived at.
+    uint32_t Arrive() {
+        return arrive(false);
+    }
+
+    // Arrives and leaves the phaser without waiting. Returns the phase arrived at.
+    uint32_t ArriveAndDeregister() {
+        return arrive(true);
+    }
+
+    // Arrives and waits for the others. Returns the new phase.
+    uint32_t ArriveAndAwaitAdvance() {
+        return AwaitAdvance(arrive(false));
+    }
+
+    // Waits until the phaser leaves the given phase and returns the new phase.
+    // Returns right away if it already has.
+    uint32_t AwaitAdvance(uint32_t phase) {
+        auto advanced = [this, phase]() { return GetPhase() != phase; };
+        if (!advanced()) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_waiters.fetch_add(1);
+            WaitStrategy::Wait(lock, m_condition, advanced, advanced);
+            m_waiters.fetch_sub(1);
+        }
+        return GetPhase();
+    }
+
+    uint32_t GetPhase() const {
+        return phaseOf(m_state.load());
+    }
+
+    unsigned int GetRegisteredParties() const {
+        return partiesOf(m_state.load(std::memory_order_relaxed));
+    }
+
+    unsigned int GetUnarrivedParties() const {
+        return unarrivedOf(m_state.load(std::memory_order_relaxed));
+    }
+
+private:
+    // Returns the number of parties after adding, or throws if they do not fit.
+    static unsigned int checkParties(unsigned int registered, unsigned int added) {
+        if (added > kPartyMask - registered) {
+            throw std::length_error("ccl::Phaser: more than 65535 parties");
+        }
+        return registered + added;
+    }
+
+    static uint64_t pack(uint32_t phase, uint64_t parties, uint64_t unarrived) {
+        return (uint64_t(phase) << kPhaseShift) | (parties << kPartiesShift) | unarrived;
+    }
+
+    static uint32_t phaseOf(uint64_t state) {
+        return static_cast<uint32_t>(state >> kPhaseShift);
+    }
+
+    static unsigned int partiesOf(uint64_t state) {
+        return static_cast<unsigned int>((state >> kPartiesShift) & kPartyMask);
+    }
+
+    static unsigned int unarrivedOf(uint64_t state) {
+        return static_cast<unsigned int>(state & kPartyMask);
+    }
+
+    // An arrival without a registered party yet to arrive is ignored.
+    uint32_t arrive(bool deregister) {
+        uint64_t state = m_state.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            unsigned int unarrived = unarrivedOf(state);
+            if (unarrived == 0) {
+                return phaseOf(state);
+            }
+            unsigned int parties = partiesOf(state) - (deregister ? 1 : 0);
+            if (unarrived == 1) {
+                next = pack(phaseOf(state) + 1, parties, parties);
+            } else {
+                next = pack(phaseOf(state), parties, unarrived - 1);
+            }
+        } while (!m_state.compare_exchange_weak(state, next));
+        if (phaseOf(next) != phaseOf(state) && m_waiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_condition.notify_all();
+        }
+        return phaseOf(state);
+    }
+};
+
+using Phaser = BasicPhaser<>;
+
+} // namespace ccl
@@ -1,105 +1,370 @@
 #pragma once
 
-#include <map>
+#include <cstddef>
+#include <algorithm>
+#include <functional>
 #include <memory>
 #include <mutex>
-#include <regex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "ccl/actor.h"
 
 namespace ccl {
 
+// Topics are split into segments at '/'. A Multicast pattern may use '+' as
+// a segment to match any one non-empty segment, and '#' as the last segment
+// to match one or more remaining segments.
+//
+// The subscriptions form an immutable trie. Publishers read the current
+// snapshot without taking the mutex, while Subscribe and Unsubscribe copy
+// the path to the changed topic and swap in a new root. A slow subscriber
+// therefore delays only the publisher that is sending to it.
 class PubSub final {
 private:
-    std::map<std::string, std::vector<std::shared_ptr<Actor>>> m_actors;
-    std::mutex m_mutex;
+    static const size_t kPatternCacheSize = 1024;
+    static const unsigned kFanoutBits = 4;
+    static const size_t kFanout = 1 << kFanoutBits;
+    static const size_t kBucketSize = 8;
+
+    struct node;
+    typedef std::vector<std::shared_ptr<Actor>> actor_list;
+
+    // Persistent hash trie from segment to child node. A table is either a
+    // bucket of entries or, once the bucket overflows, kFanout subtables
+    // indexed by the next bits of the segment hash. Updates copy only the
+    // tables on the path, so a node with many children stays cheap to change.
+    struct table {
+        std::vector<std::pair<std::string, std::shared_ptr<const node>>> entries;
+        std::vector<std::shared_ptr<const table>> subtables;
+    };
+
+    // A node of the topic trie. Never modified once published.
+    struct node {
+        std::shared_ptr<const table> children;
+        std::shared_ptr<const actor_list> actors; // null if none
+    };
+
+    typedef std::vector<const node*> node_list;
+
+    // Immutable once cached, so a hit copies only the pointer.
+    struct cacheEntry {
+        std::weak_ptr<const node> root; // the snapshot the nodes belong to
+        std::shared_ptr<const node_list> nodes;
+    };
+
+    std::shared_ptr<const node> m_root; // accessed with atomic_load/atomic_store
+    std::mutex m_mutex; // serializes the writers
+    // The nodes matched by recent Multicast patterns. The mutex guards only
+    // the lookup and insertion, not the matching.
+    std::unordered_map<std::string, cacheEntry> m_patternCache;
+    std::mutex m_cacheMutex;
 
 public:
-    PubSub() = default;
+    PubSub() : m_root(std::make_shared<node>()) {}
     ~PubSub() = default;
     PubSub(const PubSub&) = delete;
     PubSub& operator=(const PubSub&) = delete;
 
     void Subscribe(const std::string& topic, const std::shared_ptr<Actor>& actor) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_actors[topic].push_back(actor);
+        Subscribe(topic, std::vector<std::shared_ptr<Actor>>{actor});
     }
 
     void Subscribe(const std::string& topic, const std::vector<std::shared_ptr<Actor>>& actors) {
         std::lock_guard<std::mutex> lock(m_mutex);
-        for (auto& actor : actors) {
-            m_actors[topic].push_back(actor);
-        }
+        update(topic, [&](const actor_list* old) {
+            std::shared_ptr<actor_list> list = std::make_shared<actor_list>();
+            if (old != nullptr) {
+                *list = *old;
+            }
+            list->insert(list->end(), actors.begin(), actors.end());
+            return list;
+        });
     }
 
     void Unsubscribe(const std::string& topic, const std::shared_ptr<Actor>& actor) {
         std::lock_guard<std::mutex> lock(m_mutex);
-        auto& vec = m_actors[topic];
-        for (auto it = vec.begin(); it != vec.end(); it++) {
-            if (*it == actor) {
-                vec.erase(it);
-                return;
-            }
+        const node* n = find(snapshot().get(), topic);
+        if (n == nullptr || !n->actors
+                || std::find(n->actors->begin(), n->actors->end(), actor) == n->actors->end()) {
+            return;
         }
+        update(topic, [&](const actor_list* old) {
+            std::shared_ptr<actor_list> list = std::make_shared<actor_list>(*old);
+            list->erase(std::find(list->begin(), list->end(), actor));
+            return list->empty() ? nullptr : list;
+        });
     }
 
+    // The message is copied once and shared by all subscribers,
+    // see any::shared for how handlers may access it.
     void Publish(const std::string& topic, const any& message) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        for (auto& actor : m_actors[topic]) {
-            actor->Send(message);
+        std::shared_ptr<const node> root = snapshot();
+        const node* n = find(root.get(), topic);
+        if (n == nullptr || !n->actors) {
+            return;
+        }
+        any payload = share(message);
+        for (auto& actor : *n->actors) {
+            actor->Tell(payload);
         }
     }
 
     void Broadcast(const any& message) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        for (auto& pair : m_actors) {
-            for (auto& actor : pair.second) {
-                actor->Send(message);
+        std::shared_ptr<const node> root = snapshot();
+        any payload = share(message);
+        forEachDescendant(root.get(), [&](const node* n) {
+            if (n->actors) {
+                for (auto& actor : *n->actors) {
+                    actor->Tell(payload);
+                }
             }
-        }
+        });
     }
 
-    void Multicast(const std::string& topic, const any& message) {
-        std::string pattern = topic;
-        replace(pattern, "+", "\\w+");
-        int last = pattern.size() - 1;
-        if (pattern.at(last) == '#') {
-            pattern.replace(last, 1, ".+");
-        }
-        std::regex regex(pattern);
-        std::smatch match;
-
-        std::lock_guard<std::mutex> lock(m_mutex);
-        for (auto& pair : m_actors) {
-            if (std::regex_match(pair.first, match, regex)) {
-                for (auto& actor : pair.second) {
-                    actor->Send(message);
+    // Sends the message to the subscribers of every topic matching the pattern.
+    // The cost depends on the pattern depth and the number of matching topics,
+    // not on the total number of topics.
+    void Multicast(const std::string& pattern, const any& message) {
+        std::shared_ptr<const node> root = snapshot();
+        any payload = share(message);
+        std::shared_ptr<const node_list> nodes = match(root, pattern);
+        for (const node* n : *nodes) {
+            if (n->actors) {
+                for (auto& actor : *n->actors) {
+                    actor->Tell(payload);
                 }
             }
         }
     }
 
     std::vector<std::string> GetTopics() {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::shared_ptr<const node> root = snapshot();
         std::vector<std::string> vec;
-        for (auto& pair : m_actors) {
-            vec.push_back(pair.first);
-        }
+        collectTopics(root.get(), nullptr, &vec);
+        std::sort(vec.begin(), vec.end());
         return vec;
     }
 
     std::vector<std::shared_ptr<Actor>> GetSubscribers(const std::string& topic) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_actors[topic];
+        std::shared_ptr<const node> root = snapshot();
+        const node* n = find(root.get(), topic);
+        return n != nullptr && n->actors ? *n->actors : actor_list();
     }
 
 private:
-    void replace(std::string& str, const std::string& oldstr, const std::string& newstr) {
-        std::string::size_type pos = 0;
-        while (pos = str.find(oldstr, pos), pos != std::string::npos) {
-            str.replace(pos, oldstr.size(), newstr);
-            pos += newstr.size();
+    static any share(const any& message) {
+#ifdef CCL_USE_BOOST_ANY
+        return message;
+#else
+        return message.shared();
+#endif // CCL_USE_BOOST_ANY
+    }
+
+    std::shared_ptr<const node> snapshot() const {
+        return std::atomic_load(&m_root);
+    }
+
+    static std::vector<std::string> split(const std::string& topic) {
+        std::vector<std::string> segments;
+        std::string::size_type begin = 0;
+        while (true) {
+            std::string::size_type end = topic.find('/', begin);
+            if (end == std::string::npos) {
+                segments.push_back(topic.substr(begin));
+                return segments;
+            }
+            segments.push_back(topic.substr(begin, end - begin));
+            begin = end + 1;
+        }
+    }
+
+    static size_t hash(const std::string& segment) {
+        return std::hash<std::string>()(segment);
+    }
+
+    static const node* findChild(const node* n, const std::string& segment) {
+        size_t h = hash(segment);
+        const table* t = n->children.get();
+        for (unsigned shift = 0; t != nullptr; shift += kFanoutBits) {
+            if (t->subtables.empty()) {
+                for (auto& entry : t->entries) {
+                    if (entry.first == segment) {
+                        return entry.second.get();
+                    }
+                }
+                return nullptr;
+            }
+            t = t->subtables[(h >> shift) & (kFanout - 1)].get();
+        }
+        return nullptr;
+    }
+
+    // Returns a copy of t where segment maps to child, or is removed if child is null.
+    static std::shared_ptr<const table> withChild(const std::shared_ptr<const table>& t,
+            const std::string& segment, size_t h, unsigned shift, const std::shared_ptr<const node>& child) {
+        if (!t) {
+            if (!child) {
+                return nullptr;
+            }
+            std::shared_ptr<table> created = std::make_shared<table>();
+            created->entries.emplace_back(segment, child);
+            return created;
+        }
+        if (!t->subtables.empty()) {
+            std::shared_ptr<table> copy = std::make_shared<table>(*t);
+            size_t i = (h >> shift) & (kFanout - 1);
+            copy->subtables[i] = withChild(t->subtables[i], segment, h, shift + kFanoutBits, child);
+            for (auto& subtable : copy->subtables) {
+                if (subtable) {
+                    return copy;
+                }
+            }
+            return nullptr;
+        }
+        std::shared_ptr<table> copy = std::make_shared<table>(*t);
+        auto it = std::find_if(copy->entries.begin(), copy->entries.end(),
+                [&](const std::pair<std::string, std::shared_ptr<const node>>& entry) {
+                    return entry.first == segment;
+                });
+        if (it == copy->entries.end()) {
+            if (child) {
+                copy->entries.emplace_back(segment, child);
+            }
+        } else if (child) {
+            it->second = child;
+        } else {
+            copy->entries.erase(it);
+        }
+        if (copy->entries.empty()) {
+            return nullptr;
+        }
+        if (copy->entries.size() <= kBucketSize || shift + kFanoutBits >= sizeof(size_t) * 8) {
+            return copy;
+        }
+        // Split the overflowing bucket by the next bits of the hashes.
+        std::shared_ptr<table> split = std::make_shared<table>();
+        split->subtables.resize(kFanout);
+        for (auto& entry : copy->entries) {
+            size_t eh = hash(entry.first);
+            size_t i = (eh >> shift) & (kFanout - 1);
+            split->subtables[i] = withChild(split->subtables[i], entry.first, eh, shift + kFanoutBits, entry.second);
+        }
+        return split;
+    }
+
+    template<typename Func>
+    static void forEachChild(const table* t, Func&& func) {
+        if (t == nullptr) {
+            return;
+        }
+        for (auto& entry : t->entries) {
+            func(entry.first, entry.second.get());
+        }
+        for (auto& subtable : t->subtables) {
+            forEachChild(subtable.get(), func);
+        }
+    }
+
+    // Calls func with every descendant of n.
+    template<typename Func>
+    static void forEachDescendant(const node* n, Func&& func) {
+        forEachChild(n->children.get(), [&](const std::string&, const node* child) {
+            func(child);
+            forEachDescendant(child, func);
+        });
+    }
+
+    // Appends the topics that have subscribers below n, whose own topic is
+    // prefix, or which is the root if prefix is null.
+    static void collectTopics(const node* n, const std::string* prefix, std::vector<std::string>* topics) {
+        forEachChild(n->children.get(), [&](const std::string& segment, const node* child) {
+            std::string topic = prefix != nullptr ? *prefix + "/" + segment : segment;
+            if (child->actors) {
+                topics->push_back(topic);
+            }
+            collectTopics(child, &topic, topics);
+        });
+    }
+
+    static const node* find(const node* root, const std::string& topic) {
+        const node* n = root;
+        for (auto& segment : split(topic)) {
+            n = findChild(n, segment);
+            if (n == nullptr) {
+                return nullptr;
+            }
+        }
+        return n;
+    }
+
+    // Swaps in a new snapshot where the subscribers of the topic are replaced
+    // by the result of func. Must be called with m_mutex held.
+    template<typename Func>
+    void update(const std::string& topic, Func&& func) {
+        std::vector<std::string> segments = split(topic);
+        std::shared_ptr<const node> root = update(snapshot().get(), segments, 0, func);
+        std::atomic_store(&m_root, root ? root : std::make_shared<const node>());
+    }
+
+    // Returns the updated copy of n, or null if it has neither subscribers nor children.
+    template<typename Func>
+    static std::shared_ptr<const node> update(const node* n, const std::vector<std::string>& segments,
+            size_t i, Func& func) {
+        std::shared_ptr<node> copy = n != nullptr ? std::make_shared<node>(*n) : std::make_shared<node>();
+        if (i == segments.size()) {
+            copy->actors = func(n != nullptr ? n->actors.get() : nullptr);
+        } else {
+            const std::string& segment = segments[i];
+            const node* child = n != nullptr ? findChild(n, segment) : nullptr;
+            copy->children = withChild(copy->children, segment, hash(segment), 0,
+                    update(child, segments, i + 1, func));
+        }
+        if (!copy->actors && !copy->children) {
+            return nullptr;
+        }
+        return copy;
+    }
+
+    std::shared_ptr<const node_list> match(const std::shared_ptr<const node>& root, const std::string& pattern) {
+        {
+            std::lock_guard<std::mutex> lock(m_cacheMutex);
+            auto it = m_patternCache.find(pattern);
+            if (it != m_patternCache.end() && it->second.root.lock() == root) {
+                return it->second.nodes;
+            }
+        }
+        std::shared_ptr<node_list> nodes = std::make_shared<node_list>();
+        match(root.get(), split(pattern), 0, nodes.get());
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        if (m_patternCache.size() >= kPatternCacheSize) {
+            m_patternCache.clear();
+        }
+        m_patternCache[pattern] = cacheEntry{root, nodes};
+        return nodes;
+    }
+
+    static void match(const node* n, const std::vector<std::string>& segments, size_t i, node_list* nodes) {
+        if (i == segments.size()) {
+            nodes->push_back(n);
+            return;
+        }
+        const std::string& segment = segments[i];
+        if (segment == "#" && i == segments.size() - 1) {
+            forEachDescendant(n, [&](const node* descendant) {
+                nodes->push_back(descendant);
+            });
+        } else if (segment == "+") {
+            forEachChild(n->children.get(), [&](const std::string& childSegment, const node* child) {
+                if (!childSegment.empty()) {
+                    match(child, segments, i + 1, nodes);
+                }
+            });
+        } else {
+            const node* child = findChild(n, segment);
+            if (child != nullptr) {
+                match(child, segments, i + 1, nodes);
+            }
         }
     }
 };
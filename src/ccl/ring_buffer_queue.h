@@ -0,0 +1,349 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace ccl {
+
+// Bounded lock-free multi-producer/multi-consumer queue.
+// Each slot carries a sequence number that tells producers and consumers
+// whether the slot is ready for them, so Push and Pop only contend on a
+// single CAS of the head or tail position. Threads spin briefly when the
+// queue is full or empty and park on a condition variable after that.
+// The capacity is rounded up to a power of two.
+template<typename T>
+class RingBufferQueue final {
+private:
+    static const size_t kCacheLineSize = 64;
+    static const size_t kDefaultCapacity = 1024;
+    static const size_t kMaxCapacity = static_cast<size_t>(1) << (sizeof(size_t) * 8 - 2);
+    static const int kSpinCount = 100;
+
+    struct slot {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    const size_t m_mask;
+    std::unique_ptr<slot[]> m_slots;
+    char m_pad0[kCacheLineSize];
+    std::atomic<size_t> m_head; // next position to push
+    char m_pad1[kCacheLineSize];
+    std::atomic<size_t> m_tail; // next position to pop
+    char m_pad2[kCacheLineSize];
+    std::atomic<int> m_pushWaiters;
+    std::atomic<int> m_popWaiters;
+    std::mutex m_mutex;
+    std::condition_variable m_notFullCondition;
+    std::condition_variable m_notEmptyCondition;
+
+public:
+    // Capacity 0 or SIZE_MAX selects the default capacity because the ring buffer cannot be unbounded.
+    RingBufferQueue(size_t capacity = kDefaultCapacity)
+            : m_mask(roundUpCapacity(capacity) - 1), m_slots(new slot[m_mask + 1])
+            , m_head(0), m_tail(0), m_pushWaiters(0), m_popWaiters(0) {
+        for (size_t i = 0; i <= m_mask; i++) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~RingBufferQueue() {
+        while (tryPop(nullptr)) {}
+    }
+
+    RingBufferQueue(const RingBufferQueue&) = delete;
+    RingBufferQueue& operator=(const RingBufferQueue&) = delete;
+
+    size_t Capacity() const {
+        return m_mask + 1;
+    }
+
+    bool Empty() const {
+        return Size() == 0;
+    }
+
+    // Returns an approximate size while other threads are pushing or popping.
+    size_t Size() const {
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        size_t head = m_head.load(std::memory_order_acquire);
+        return head > tail ? head - tail : 0;
+    }
+
+    void Push(const T& element) {
+        push(element);
+    }
+
+    void Push(T&& element) {
+        push(std::move(element));
+    }
+
+    template<class Rep, class Period>
+    std::cv_status Push(const T& element, const std::chrono::duration<Rep, Period>& timeout) {
+        return push(element, std::chrono::steady_clock::now() + timeout);
+    }
+
+    template<class Rep, class Period>
+    std::cv_status Push(T&& element, const std::chrono::duration<Rep, Period>& timeout) {
+        return push(std::move(element), std::chrono::steady_clock::now() + timeout);
+    }
+
+    // Claims slots one by one but notifies the consumers once at the end,
+    // or before blocking when the buffer fills up.
+    template<typename InputIt>
+    void PushAll(InputIt first, InputIt last) {
+        bool pushed = false;
+        for (; first != last; ++first) {
+            if (tryPush(*first)) {
+                pushed = true;
+                continue;
+            }
+            if (pushed) {
+                notifyNotEmpty();
+            }
+            push(*first);
+            pushed = false;
+        }
+        if (pushed) {
+            notifyNotEmpty();
+        }
+    }
+
+    T Pop() {
+        T element;
+        for (int i = 0; !tryPop(&element); i++) {
+            if (i < kSpinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_popWaiters.fetch_add(1);
+            while (isEmpty()) {
+                m_notEmptyCondition.wait(lock);
+            }
+            m_popWaiters.fetch_sub(1);
+        }
+        notifyNotFull();
+        return element;
+    }
+
+    template<class Rep, class Period>
+    std::cv_status Pop(const std::chrono::duration<Rep, Period>& timeout, T* element) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        for (int i = 0; !tryPop(element); i++) {
+            if (i < kSpinCount) {
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    return std::cv_status::timeout;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_popWaiters.fetch_add(1);
+            while (isEmpty()) {
+                if (m_notEmptyCondition.wait_until(lock, deadline) == std::cv_status::timeout) {
+                    m_popWaiters.fetch_sub(1);
+                    return std::cv_status::timeout;
+                }
+            }
+            m_popWaiters.fetch_sub(1);
+        }
+        notifyNotFull();
+        return std::cv_status::no_timeout;
+    }
+
+    // Waits until the queue is not empty and moves up to maxItems elements to out.
+    // Returns the number of moved elements.
+    template<typename OutputIt>
+    size_t DrainTo(OutputIt out, size_t maxItems) {
+        if (maxItems == 0) {
+            return 0;
+        }
+        *out = Pop();
+        ++out;
+        return 1 + drain(out, maxItems - 1);
+    }
+
+    // Returns 0 if the queue stays empty until the timeout.
+    template<typename OutputIt, class Rep, class Period>
+    size_t DrainTo(OutputIt out, size_t maxItems, const std::chrono::duration<Rep, Period>& timeout) {
+        if (maxItems == 0) {
+            return 0;
+        }
+        T element;
+        if (Pop(timeout, &element) == std::cv_status::timeout) {
+            return 0;
+        }
+        *out = std::move(element);
+        ++out;
+        return 1 + drain(out, maxItems - 1);
+    }
+
+    void Clear() {
+        bool popped = false;
+        while (tryPop(nullptr)) {
+            popped = true;
+        }
+        if (popped) {
+            notifyNotFull();
+        }
+    }
+
+private:
+    static size_t roundUpCapacity(size_t capacity) {
+        if (capacity == 0 || capacity == SIZE_MAX) {
+            return kDefaultCapacity;
+        }
+        if (capacity > kMaxCapacity) {
+            return kMaxCapacity;
+        }
+        size_t n = 2;
+        while (n < capacity) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    template<typename OutputIt>
+    size_t drain(OutputIt& out, size_t maxItems) {
+        T element;
+        size_t n = 0;
+        for (; n < maxItems && tryPop(&element); n++) {
+            *out = std::move(element);
+            ++out;
+        }
+        if (n > 0) {
+            notifyNotFull();
+        }
+        return n;
+    }
+
+    template<typename U>
+    void push(U&& element) {
+        for (int i = 0; !tryPush(std::forward<U>(element)); i++) {
+            if (i < kSpinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pushWaiters.fetch_add(1);
+            while (isFull()) {
+                m_notFullCondition.wait(lock);
+            }
+            m_pushWaiters.fetch_sub(1);
+        }
+        notifyNotEmpty();
+    }
+
+    template<typename U, typename TimePoint>
+    std::cv_status push(U&& element, const TimePoint& deadline) {
+        for (int i = 0; !tryPush(std::forward<U>(element)); i++) {
+            if (i < kSpinCount) {
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    return std::cv_status::timeout;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_pushWaiters.fetch_add(1);
+            while (isFull()) {
+                if (m_notFullCondition.wait_until(lock, deadline) == std::cv_status::timeout) {
+                    m_pushWaiters.fetch_sub(1);
+                    return std::cv_status::timeout;
+                }
+            }
+            m_pushWaiters.fetch_sub(1);
+        }
+        notifyNotEmpty();
+        return std::cv_status::no_timeout;
+    }
+
+    // The element is constructed only when a slot was claimed, so a failed
+    // attempt leaves an rvalue argument untouched.
+    template<typename U>
+    bool tryPush(U&& element) {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        slot* s;
+        while (true) {
+            s = &m_slots[pos & m_mask];
+            size_t seq = s->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) { // full
+                return false;
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+        new (&s->storage) T(std::forward<U>(element));
+        s->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T* element) {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        slot* s;
+        while (true) {
+            s = &m_slots[pos & m_mask];
+            size_t seq = s->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) { // empty
+                return false;
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        T* held = reinterpret_cast<T*>(&s->storage);
+        if (element != nullptr) {
+            *element = std::move(*held);
+        }
+        held->~T();
+        s->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Waiters register themselves before re-checking the state under the
+    // mutex, and wakers publish the state before reading the waiter count,
+    // so a wake-up cannot be lost between the check and the wait.
+    void notifyNotEmpty() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_popWaiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_notEmptyCondition.notify_all();
+        }
+    }
+
+    void notifyNotFull() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_pushWaiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_notFullCondition.notify_all();
+        }
+    }
+
+    bool isEmpty() {
+        return m_head.load() == m_tail.load();
+    }
+
+    bool isFull() {
+        return m_head.load() - m_tail.load() > m_mask;
+    }
+};
+
+} // namespace ccl
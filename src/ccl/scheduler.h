@@ -1,137 +1,744 @@
 #pragma once
 
 #include <cstdint>
-#include <ctime>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <vector>
+#include "ccl/trace.h"
+#include "ccl/wait_strategy.h"
 
 namespace ccl {
 
+enum class SchedulerBackend {
+    Heap, // binary heap: O(log n) insertion and expiry
+    TimingWheel, // hierarchical timing wheel: O(1) insertion and expiry at tick resolution
+};
+
+// What a periodic task does about the runs it missed because its worker
+// was busy or the system was suspended. A run is missed when the next one
+// is already due.
+enum class MissedRunPolicy {
+    CatchUp, // runs every missed execution back to back, each counting toward the repeat count
+    Skip, // runs once and drops the missed executions, which do not count toward the repeat count
+    Coalesce, // runs once for all missed executions, which count toward the repeat count
+};
+
 struct scheduledTask {
     std::function<void()> task;
-    int64_t execTime; // Unix time [ms]
-    int64_t period; // [ms]
+    int64_t execTime; // steady_clock time [ns]
+    int64_t period; // [ns]
     int16_t repeatCount;
+    uint64_t id; // set by PopExpired to the id that Push returned
+};
+
+// Pending tasks of a Scheduler, ordered by execution time.
+// Push returns an id for Cancel, which stays valid until the task has run
+// for the last time or was cancelled.
+class timerQueue {
+private:
+    MissedRunPolicy m_policy;
+
+public:
+    timerQueue() : m_policy(MissedRunPolicy::CatchUp) {}
+
+    virtual ~timerQueue() = default;
+
+    void SetMissedRunPolicy(MissedRunPolicy policy) {
+        m_policy = policy;
+    }
+
+    virtual bool Empty() const = 0;
+
+    virtual uint64_t Push(scheduledTask&& task, int64_t now) = 0;
+
+    // Returns false if the task is no longer pending.
+    virtual bool Cancel(uint64_t id) = 0;
+
+    // Returns the time at which PopExpired should be called next.
+    // The queue must not be empty.
+    virtual int64_t NextTime() = 0;
+
+    // Moves the tasks whose execution time has come to expired, or copies
+    // them and keeps them queued for their next period.
+    virtual void PopExpired(int64_t now, std::vector<scheduledTask>* expired) = 0;
+
+    virtual void Clear() = 0;
+
+protected:
+    static uint64_t makeId(uint32_t timer, uint32_t generation) {
+        return (uint64_t(generation) << 32) | timer;
+    }
+
+    // Appends the run of an expired task to expired, and returns true if the
+    // task stays queued for its next execution.
+    bool expire(scheduledTask* task, uint64_t id, int64_t now, std::vector<scheduledTask>* expired) const {
+        task->id = id;
+        if (task->period <= 0 || task->repeatCount == 0) {
+            expired->push_back(std::move(*task));
+            return false;
+        }
+        int64_t runs = 1; // the executions due by now, run at once
+        if (m_policy != MissedRunPolicy::CatchUp) {
+            runs += (now - task->execTime) / task->period;
+        }
+        int64_t counted = m_policy == MissedRunPolicy::Skip ? 1 : runs; // taken from the repeat count
+        int64_t remaining = task->repeatCount; // executions after this one, or forever if negative
+        if (remaining >= 0 && counted > remaining) {
+            expired->push_back(std::move(*task));
+            return false;
+        }
+        expired->push_back(*task);
+        task->execTime += task->period * runs; // the next due time after now, unless CatchUp
+        if (remaining >= 0) {
+            task->repeatCount = static_cast<int16_t>(remaining - counted);
+        }
+        return true;
+    }
 };
 
-struct scheduledTaskComparator {
-    bool operator()(const scheduledTask& a, const scheduledTask& b) {
-        return a.execTime > b.execTime;
+// Binary heap with lazy deletion: a cancelled task stays in the heap as a
+// tombstone until it reaches the top, or until the tombstones make up half
+// of the heap and are removed at once.
+class timerHeap final : public timerQueue {
+private:
+    static const size_t kMinCompaction = 64;
+
+    struct entry {
+        scheduledTask task;
+        uint32_t timer;
+        uint32_t generation;
+    };
+
+    struct entryComparator {
+        bool operator()(const entry& a, const entry& b) const {
+            return a.task.execTime > b.task.execTime;
+        }
+    };
+
+    std::vector<entry> m_heap;
+    std::vector<uint32_t> m_generations; // bumped whenever a timer is retired
+    std::vector<uint32_t> m_freeTimers;
+    size_t m_cancelled; // tombstones in m_heap
+
+public:
+    timerHeap() : m_cancelled(0) {}
+
+    bool Empty() const override {
+        return m_heap.size() == m_cancelled;
+    }
+
+    uint64_t Push(scheduledTask&& task, int64_t now) override {
+        uint32_t timer;
+        if (!m_freeTimers.empty()) {
+            timer = m_freeTimers.back();
+            m_freeTimers.pop_back();
+        } else {
+            timer = static_cast<uint32_t>(m_generations.size());
+            m_generations.push_back(0);
+        }
+        m_heap.push_back(entry{std::move(task), timer, m_generations[timer]});
+        std::push_heap(m_heap.begin(), m_heap.end(), entryComparator());
+        return makeId(timer, m_generations[timer]);
+    }
+
+    bool Cancel(uint64_t id) override {
+        uint32_t timer = static_cast<uint32_t>(id);
+        if (timer >= m_generations.size() || m_generations[timer] != static_cast<uint32_t>(id >> 32)) {
+            return false;
+        }
+        retire(timer);
+        m_cancelled++;
+        if (m_cancelled >= kMinCompaction && m_cancelled * 2 > m_heap.size()) {
+            compact();
+        }
+        return true;
+    }
+
+    int64_t NextTime() override {
+        dropCancelled();
+        return m_heap.front().task.execTime;
+    }
+
+    void PopExpired(int64_t now, std::vector<scheduledTask>* expired) override {
+        while (true) {
+            dropCancelled();
+            if (m_heap.empty() || m_heap.front().task.execTime > now) {
+                break;
+            }
+            std::pop_heap(m_heap.begin(), m_heap.end(), entryComparator());
+            entry& e = m_heap.back();
+            if (expire(&e.task, makeId(e.timer, e.generation), now, expired)) {
+                std::push_heap(m_heap.begin(), m_heap.end(), entryComparator());
+            } else {
+                retire(e.timer);
+                m_heap.pop_back();
+            }
+        }
+    }
+
+    void Clear() override {
+        m_heap.clear();
+        m_cancelled = 0;
+        m_freeTimers.clear();
+        for (uint32_t timer = 0; timer < m_generations.size(); timer++) {
+            m_generations[timer]++;
+            m_freeTimers.push_back(timer);
+        }
+    }
+
+private:
+    bool alive(const entry& e) const {
+        return m_generations[e.timer] == e.generation;
+    }
+
+    void retire(uint32_t timer) {
+        m_generations[timer]++;
+        m_freeTimers.push_back(timer);
+    }
+
+    void dropCancelled() {
+        while (!m_heap.empty() && !alive(m_heap.front())) {
+            std::pop_heap(m_heap.begin(), m_heap.end(), entryComparator());
+            m_heap.pop_back();
+            m_cancelled--;
+        }
+    }
+
+    void compact() {
+        m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(),
+                [this](const entry& e) { return !alive(e); }), m_heap.end());
+        std::make_heap(m_heap.begin(), m_heap.end(), entryComparator());
+        m_cancelled = 0;
     }
 };
 
-class Scheduler final {
+// Hierarchical timing wheel with kLevels levels of kSlots slots each.
+// A level-0 slot holds the tasks due at one tick. A slot of level n holds
+// the tasks due within kSlots^n ticks, which are redistributed to the lower
+// levels when the wheel reaches them. Tasks fire up to one tick late.
+class timingWheel final : public timerQueue {
+private:
+    static const int kLevels = 6;
+    static const int kSlotBits = 6;
+    static const int64_t kSlots = 1 << kSlotBits;
+    static const size_t kChunkSize = 1024;
+
+    struct link {
+        link* prev;
+        link* next;
+    };
+
+    struct node : link {
+        scheduledTask task;
+        uint32_t timer; // position in m_chunks
+        uint32_t generation; // bumped whenever the node is released
+        int level;
+        int index;
+    };
+
+    const int64_t m_tick; // [ns]
+    int64_t m_current; // the last processed tick
+    size_t m_size;
+    link m_slots[kLevels][kSlots]; // sentinels of circular lists
+    uint64_t m_occupied[kLevels]; // bit i is set if slot i is not empty
+    // Nodes are allocated in chunks and reused, so that timers do not allocate
+    // in steady state and Clear walks memory sequentially.
+    std::vector<std::unique_ptr<node[]>> m_chunks;
+    link* m_free; // released nodes, linked by next
+
+public:
+    timingWheel(int64_t tick, int64_t now)
+            : m_tick(tick > 0 ? tick : 1), m_current(now / m_tick), m_size(0), m_occupied(), m_free(nullptr) {
+        for (auto& level : m_slots) {
+            for (auto& slot : level) {
+                slot.prev = slot.next = &slot;
+            }
+        }
+    }
+
+    timingWheel(const timingWheel&) = delete;
+    timingWheel& operator=(const timingWheel&) = delete;
+
+    bool Empty() const override {
+        return m_size == 0;
+    }
+
+    uint64_t Push(scheduledTask&& task, int64_t now) override {
+        if (m_size == 0) {
+            m_current = std::max(m_current, now / m_tick);
+        }
+        if (m_free == nullptr) {
+            grow();
+        }
+        node* n = static_cast<node*>(m_free);
+        m_free = m_free->next;
+        n->task = std::move(task);
+        insert(n);
+        m_size++;
+        return makeId(n->timer, n->generation);
+    }
+
+    bool Cancel(uint64_t id) override {
+        uint32_t timer = static_cast<uint32_t>(id);
+        if (timer >= m_chunks.size() * kChunkSize) {
+            return false;
+        }
+        node* n = &m_chunks[timer / kChunkSize][timer % kChunkSize];
+        if (n->generation != static_cast<uint32_t>(id >> 32)) {
+            return false;
+        }
+        unlink(n);
+        link* slot = &m_slots[n->level][n->index];
+        if (slot->next == slot) {
+            m_occupied[n->level] &= ~(uint64_t(1) << n->index);
+        }
+        release(n);
+        m_size--;
+        return true;
+    }
+
+    int64_t NextTime() override {
+        return nextTick() * m_tick;
+    }
+
+    void PopExpired(int64_t now, std::vector<scheduledTask>* expired) override {
+        int64_t target = now / m_tick;
+        while (m_size > 0) {
+            int64_t next = nextTick();
+            if (next > target) {
+                break;
+            }
+            m_current = next;
+            for (int level = kLevels - 1; level > 0; level--) {
+                int shift = kSlotBits * level;
+                if ((m_current & ((int64_t(1) << shift) - 1)) == 0) {
+                    cascade(level, (m_current >> shift) & (kSlots - 1));
+                }
+            }
+            // A repeating task may be inserted into the same slot again,
+            // so the slot is detached before its tasks are expired.
+            link pending;
+            detach(0, m_current & (kSlots - 1), &pending);
+            while (pending.next != &pending) {
+                node* n = static_cast<node*>(pending.next);
+                unlink(n);
+                if (expire(&n->task, makeId(n->timer, n->generation), now, expired)) {
+                    insert(n);
+                } else {
+                    release(n);
+                    m_size--;
+                }
+            }
+        }
+        m_current = std::max(m_current, target);
+    }
+
+    void Clear() override {
+        m_free = nullptr;
+        for (size_t i = m_chunks.size(); i-- > 0;) {
+            node* chunk = m_chunks[i].get();
+            for (size_t j = kChunkSize; j-- > 0;) {
+                chunk[j].task.task = nullptr;
+                chunk[j].generation++;
+                chunk[j].next = m_free;
+                m_free = &chunk[j];
+            }
+        }
+        for (auto& level : m_slots) {
+            for (auto& slot : level) {
+                slot.prev = slot.next = &slot;
+            }
+        }
+        std::fill(std::begin(m_occupied), std::end(m_occupied), 0);
+        m_size = 0;
+    }
+
+private:
+    static int countTrailingZeros(uint64_t x) { // x must not be 0
+#if defined(__GNUC__)
+        return __builtin_ctzll(x);
+#else
+        int n = 0;
+        for (; (x & 1) == 0; x >>= 1) {
+            n++;
+        }
+        return n;
+#endif
+    }
+
+    static uint64_t rotateRight(uint64_t x, int n) {
+        return n == 0 ? x : (x >> n) | (x << (kSlots - n));
+    }
+
+    static void unlink(link* l) {
+        l->prev->next = l->next;
+        l->next->prev = l->prev;
+    }
+
+    void grow() {
+        node* chunk = new node[kChunkSize];
+        uint32_t first = static_cast<uint32_t>(m_chunks.size() * kChunkSize);
+        m_chunks.emplace_back(chunk);
+        for (size_t j = kChunkSize; j-- > 0;) {
+            chunk[j].timer = first + static_cast<uint32_t>(j);
+            chunk[j].generation = 0;
+            chunk[j].next = m_free;
+            m_free = &chunk[j];
+        }
+    }
+
+    void release(node* n) {
+        n->task.task = nullptr;
+        n->generation++;
+        n->next = m_free;
+        m_free = n;
+    }
+
+    void insert(node* n) {
+        // Round up, so that a task never fires before its time.
+        int64_t expire = std::max((n->task.execTime + m_tick - 1) / m_tick, m_current);
+        int64_t delta = expire - m_current;
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (int64_t(1) << (kSlotBits * (level + 1)))) {
+            level++;
+        }
+        if (delta >= (int64_t(1) << (kSlotBits * kLevels))) { // beyond the wheel: wait in the last slot
+            expire = m_current + (int64_t(1) << (kSlotBits * kLevels)) - 1;
+        }
+        int index = (expire >> (kSlotBits * level)) & (kSlots - 1);
+        link* slot = &m_slots[level][index];
+        n->level = level;
+        n->index = index;
+        n->prev = slot->prev;
+        n->next = slot;
+        slot->prev->next = n;
+        slot->prev = n;
+        m_occupied[level] |= uint64_t(1) << index;
+    }
+
+    // Moves the nodes of a slot to the list of the sentinel pending.
+    void detach(int level, int index, link* pending) {
+        link* slot = &m_slots[level][index];
+        if (slot->next == slot) {
+            pending->prev = pending->next = pending;
+            return;
+        }
+        pending->prev = slot->prev;
+        pending->next = slot->next;
+        pending->next->prev = pending;
+        pending->prev->next = pending;
+        slot->prev = slot->next = slot;
+        m_occupied[level] &= ~(uint64_t(1) << index);
+    }
+
+    // Moves the tasks of a slot to the lower levels.
+    void cascade(int level, int index) {
+        link pending;
+        detach(level, index, &pending);
+        while (pending.next != &pending) {
+            node* n = static_cast<node*>(pending.next);
+            unlink(n);
+            insert(n);
+        }
+    }
+
+    // Returns the next tick at which a slot expires or must be cascaded.
+    int64_t nextTick() const {
+        int64_t next = INT64_MAX;
+        if (m_occupied[0] != 0) {
+            int index = m_current & (kSlots - 1);
+            next = m_current + countTrailingZeros(rotateRight(m_occupied[0], index));
+        }
+        for (int level = 1; level < kLevels; level++) {
+            if (m_occupied[level] == 0) {
+                continue;
+            }
+            int shift = kSlotBits * level;
+            int index = (m_current >> shift) & (kSlots - 1);
+            uint64_t ahead = rotateRight(m_occupied[level], index) & ~uint64_t(1);
+            int64_t distance = ahead != 0 ? countTrailingZeros(ahead) : kSlots;
+            next = std::min(next, ((m_current >> shift) + distance) << shift);
+        }
+        return next;
+    }
+};
+
+class TimerHandle;
+
+// The Scheduler that a TimerHandle refers to.
+class timerOwner {
+public:
+    virtual ~timerOwner() = default;
+
+    virtual bool Cancel(const TimerHandle& handle) = 0;
+};
+
+// Refers to a task scheduled by a Scheduler. Must not be used after the
+// Scheduler has been destroyed.
+class TimerHandle final {
+private:
+    template<typename WaitStrategy>
+    friend class BasicScheduler;
+
+    timerOwner* m_owner;
+    uint64_t m_id;
+
+    TimerHandle(timerOwner* owner, uint64_t id) : m_owner(owner), m_id(id) {}
+
+public:
+    TimerHandle() : m_owner(nullptr), m_id(0) {}
+
+    // Cancels the task, or the remaining executions of a periodic task, in O(1).
+    // This includes the runs that a late task was due to catch up on; only
+    // a run that has already started completes.
+    // Returns false if it has already run for the last time or was cancelled.
+    bool Cancel() {
+        return m_owner != nullptr && m_owner->Cancel(*this);
+    }
+};
+
+// Runs tasks at given times. By default the tasks run on the timer thread,
+// so a slow task delays the later ones. With an executor, such as a
+// ThreadPool, the timer thread only hands the expired tasks over, and the
+// runs of a periodic task may overlap if one takes longer than the period.
+// Times are kept on steady_clock with nanosecond resolution, so changes of the
+// system clock do not delay or bunch the tasks. A system_clock time point is
+// converted to steady_clock when the task is scheduled.
+// WaitStrategy decides how the timer thread waits for the next task.
+template<typename WaitStrategy = BlockingWait>
+class BasicScheduler final : public timerOwner {
 private:
     bool m_stopped;
+    std::unique_ptr<timerQueue> m_queue;
     std::unique_ptr<std::thread> m_thread;
-    std::priority_queue<scheduledTask, std::vector<scheduledTask>, scheduledTaskComparator> m_queue;
     std::mutex m_mutex;
     std::condition_variable m_condition;
+    std::atomic<int64_t> m_spinThreshold; // [ns]
+    std::atomic<uint64_t> m_version; // incremented whenever the earliest task may have changed
+    // The runs popped by the worker; those from m_nextRun on have not started
+    // yet, so that Cancel can still drop them.
+    std::vector<scheduledTask> m_runs;
+    size_t m_nextRun;
+    std::function<void(std::function<void()>&&)> m_execute; // null to run on the timer thread
 
 public:
-    Scheduler() : m_stopped(false) {
-        using namespace std::chrono;
+    // The tick is the resolution of the timing wheel and is ignored by the heap.
+    explicit BasicScheduler(SchedulerBackend backend = SchedulerBackend::Heap,
+            std::chrono::nanoseconds tick = std::chrono::milliseconds(1))
+            : m_stopped(false), m_spinThreshold(0), m_version(0), m_nextRun(0) {
+        start(backend, tick);
+    }
 
-        auto worker = [this]() {
-            while (true) {
-                scheduledTask schedTask;
-                {
-                    std::unique_lock<std::mutex> lock(m_mutex);
-                    while (!m_stopped && m_queue.empty()) {
-                        m_condition.wait(lock);
-                    }
-                    if (m_stopped && m_queue.empty()) {
-                        return;
-                    }
-                    schedTask = m_queue.top();
-                    auto now = Scheduler::toUnixTime(system_clock::now());
-                    if (schedTask.execTime <= now) { // fired
-                        m_queue.pop();
-                        if (schedTask.period > 0 && schedTask.repeatCount != 0) { // repeat
-                            schedTask.execTime += schedTask.period;
-                            schedTask.repeatCount--;
-                            m_queue.push(schedTask); // reschedule
-                        }
-                    } else {
-                        auto execTp = Scheduler::toTimePoint<system_clock>(schedTask.execTime);
-                        m_condition.wait_until(lock, execTp);
-                        continue;
-                    }
-                }
-                schedTask.task();
-            }
-        };
-        m_thread = std::unique_ptr<std::thread>(new std::thread(std::move(worker)));
+    // Runs the tasks with executor->Dispatch, e.g. on a ThreadPool. Tasks
+    // that the executor rejects, e.g. after a shutdown, are discarded.
+    template<typename Executor>
+    explicit BasicScheduler(const std::shared_ptr<Executor>& executor,
+            SchedulerBackend backend = SchedulerBackend::Heap,
+            std::chrono::nanoseconds tick = std::chrono::milliseconds(1))
+            : m_stopped(false), m_spinThreshold(0), m_version(0), m_nextRun(0)
+            , m_execute([executor](std::function<void()>&& task) { executor->Dispatch(std::move(task)); }) {
+        start(backend, tick);
     }
 
-    ~Scheduler() {
+    ~BasicScheduler() {
         {
             std::lock_guard<std::mutex> lock(m_mutex);
             m_stopped = true;
-            clearQueue();
+            m_queue->Clear();
+            m_version++;
         }
         m_condition.notify_one();
         m_thread->join();
     }
 
-    Scheduler(const Scheduler&) = delete;
-    Scheduler& operator=(const Scheduler&) = delete;
+    BasicScheduler(const BasicScheduler&) = delete;
+    BasicScheduler& operator=(const BasicScheduler&) = delete;
 
-    void Schedule(const std::chrono::time_point<std::chrono::system_clock>& startTime,
+    TimerHandle Schedule(const std::chrono::time_point<std::chrono::steady_clock>& startTime,
             std::function<void()>&& task) {
-        int64_t startUnixTime = Scheduler::toUnixTime(startTime);
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_queue.push(scheduledTask{task, startUnixTime, 0, 0});
-        }
-        m_condition.notify_one();
+        return push(scheduledTask{std::move(task), BasicScheduler::toNanoseconds(startTime), 0, 0});
+    }
+
+    TimerHandle Schedule(const std::chrono::time_point<std::chrono::system_clock>& startTime,
+            std::function<void()>&& task) {
+        return Schedule(BasicScheduler::toSteady(startTime), std::move(task));
     }
 
     // Schedules the task for repeated execution.
     // Executes the task forever if repeatCount is less than 0.
     template<class Rep, class Period>
-    void Schedule(const std::chrono::time_point<std::chrono::system_clock>& firstTime,
+    TimerHandle Schedule(const std::chrono::time_point<std::chrono::steady_clock>& firstTime,
             const std::chrono::duration<Rep, Period>& period, int16_t repeatCount, std::function<void()>&& task) {
-        int64_t firstUnixTime = Scheduler::toUnixTime(firstTime);
-        int64_t periodMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(period).count();
+        int64_t periodNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(period).count();
+        return push(scheduledTask{std::move(task), BasicScheduler::toNanoseconds(firstTime), periodNanoseconds,
+                repeatCount});
+    }
+
+    template<class Rep, class Period>
+    TimerHandle Schedule(const std::chrono::time_point<std::chrono::system_clock>& firstTime,
+            const std::chrono::duration<Rep, Period>& period, int16_t repeatCount, std::function<void()>&& task) {
+        return Schedule(BasicScheduler::toSteady(firstTime), period, repeatCount, std::move(task));
+    }
+
+    // Cancel all scheduled tasks.
+    void Cancel() {
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            m_queue.push(scheduledTask{task, firstUnixTime, periodMilliseconds, repeatCount});
+            m_queue->Clear();
+            m_runs.resize(m_nextRun);
+            m_version++;
         }
         m_condition.notify_one();
     }
 
-    // Cancel all scheduled tasks.
-    void Cancel() {
+    // Cancels one task. See TimerHandle::Cancel.
+    bool Cancel(const TimerHandle& handle) override {
+        if (handle.m_owner != this) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bool cancelled = m_queue->Cancel(handle.m_id);
+        for (size_t i = m_nextRun; i < m_runs.size(); i++) {
+            if (m_runs[i].id == handle.m_id && m_runs[i].task) {
+                m_runs[i].task = nullptr;
+                cancelled = true;
+            }
+        }
+        return cancelled;
+    }
+
+    void SetMissedRunPolicy(MissedRunPolicy policy) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue->SetMissedRunPolicy(policy);
+    }
+
+    // Makes the worker sleep only until the given time before the next
+    // deadline and spin from then on. Waking up from a sleep may take tens
+    // of microseconds, so spinning makes sub-millisecond deadlines precise
+    // at the cost of a busy core. 0, the default, disables spinning.
+    void SetSpinThreshold(std::chrono::nanoseconds spinThreshold) {
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            clearQueue();
+            m_spinThreshold = std::max<int64_t>(spinThreshold.count(), 0);
+            m_version++;
         }
         m_condition.notify_one();
     }
 
 private:
-    template<typename Clock>
-    static int64_t toUnixTime(const std::chrono::time_point<Clock>& tp) {
-        return std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
+    void start(SchedulerBackend backend, std::chrono::nanoseconds tick) {
+        if (backend == SchedulerBackend::TimingWheel) {
+            m_queue.reset(new timingWheel(tick.count(), BasicScheduler::now()));
+        } else {
+            m_queue.reset(new timerHeap());
+        }
+        auto worker = [this]() {
+            CCL_TRACE_THREAD_NAME("ccl::Scheduler");
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    WaitStrategy::Wait(lock, m_condition, [this]() { return m_stopped || !m_queue->Empty(); });
+                    if (m_stopped && m_queue->Empty()) {
+                        return;
+                    }
+                    int64_t now = BasicScheduler::now();
+                    int64_t nextTime = m_queue->NextTime();
+                    if (nextTime > now) {
+                        int64_t spinThreshold = m_spinThreshold.load(std::memory_order_relaxed);
+                        uint64_t version = m_version.load();
+                        if (nextTime - now > spinThreshold) {
+                            auto changed = [this, version]() { return m_version.load() != version; };
+                            WaitStrategy::WaitUntil(lock, m_condition,
+                                    BasicScheduler::toTimePoint(nextTime - spinThreshold), changed, changed);
+                        } else {
+                            lock.unlock();
+                            spinUntil(nextTime, version);
+                        }
+                        continue;
+                    }
+                    m_queue->PopExpired(now, &m_runs); // fired, and periodic tasks rescheduled
+                }
+                runExpired();
+            }
+        };
+        m_thread = std::unique_ptr<std::thread>(new std::thread(std::move(worker)));
+    }
+
+    // Runs the popped tasks one by one. Each run is taken under the lock, so
+    // that one which was cancelled meanwhile, or all after a stop, are dropped
+    // even if a late periodic task has queued many runs.
+    void runExpired() {
+        while (true) {
+            scheduledTask schedTask;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_stopped || m_nextRun == m_runs.size()) {
+                    m_runs.clear();
+                    m_nextRun = 0;
+                    return;
+                }
+                schedTask = std::move(m_runs[m_nextRun++]);
+            }
+            if (!schedTask.task) { // cancelled
+                continue;
+            }
+            // The argument is how late the task fired [ns].
+            CCL_TRACE_INSTANT("Scheduler::Fire", std::max<int64_t>(BasicScheduler::now() - schedTask.execTime, 0));
+            if (m_execute) {
+                m_execute(std::move(schedTask.task));
+            } else {
+                CCL_TRACE_SCOPE("Scheduler::Run");
+                schedTask.task();
+            }
+        }
     }
 
-    template<typename Clock>
-    static std::chrono::time_point<Clock> toTimePoint(int64_t unixTime) {
-        return std::chrono::time_point<Clock>(std::chrono::duration<int64_t, std::milli>(unixTime));
+    static int64_t now() {
+        return BasicScheduler::toNanoseconds(std::chrono::steady_clock::now());
     }
 
-    void clearQueue() {
-        while (!m_queue.empty()) {
-            m_queue.pop();
+    static int64_t toNanoseconds(const std::chrono::time_point<std::chrono::steady_clock>& tp) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+    }
+
+    static std::chrono::time_point<std::chrono::steady_clock> toTimePoint(int64_t time) {
+        return std::chrono::time_point<std::chrono::steady_clock>(
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(time)));
+    }
+
+    static std::chrono::time_point<std::chrono::steady_clock> toSteady(
+            const std::chrono::time_point<std::chrono::system_clock>& tp) {
+        using namespace std::chrono;
+        return steady_clock::now() + duration_cast<steady_clock::duration>(tp - system_clock::now());
+    }
+
+    // Returns when the time has come or another task may be due earlier.
+    void spinUntil(int64_t time, uint64_t version) {
+        while (BasicScheduler::now() < time && m_version.load() == version) {
+            std::this_thread::yield();
         }
     }
+
+    TimerHandle push(scheduledTask&& task) {
+        int64_t now = BasicScheduler::now();
+        uint64_t id;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            id = m_queue->Push(std::move(task), now);
+            m_version++;
+        }
+        m_condition.notify_one();
+        return TimerHandle(this, id);
+    }
 };
 
+using Scheduler = BasicScheduler<>;
+
 } // namespace ccl
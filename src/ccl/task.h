@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ccl {
+
+// Move-only callable wrapper for void() tasks.
+// Callables that fit into InlineSize bytes and are nothrow move constructible
+// are stored in place, so wrapping them never allocates. Larger callables fall
+// back to the heap. Unlike std::function, the callable need not be copyable.
+template<size_t InlineSize>
+class BasicTask final {
+private:
+    static_assert(InlineSize >= sizeof(void*), "InlineSize must hold at least a pointer");
+
+    typedef typename std::aligned_storage<InlineSize, alignof(void*)>::type storage_type;
+
+    struct vtable {
+        void (*invoke)(storage_type&);
+        void (*move)(storage_type& dst, storage_type& src); // also destroys src
+        void (*destroy)(storage_type&);
+    };
+
+    template<typename F>
+    struct inlineFunc {
+        static F& get(storage_type& s) {
+            return *reinterpret_cast<F*>(&s);
+        }
+        static void invoke(storage_type& s) {
+            get(s)();
+        }
+        static void move(storage_type& dst, storage_type& src) {
+            new (&dst) F(std::move(get(src)));
+            get(src).~F();
+        }
+        static void destroy(storage_type& s) {
+            get(s).~F();
+        }
+        static const vtable* table() {
+            static const vtable vt = {&invoke, &move, &destroy};
+            return &vt;
+        }
+    };
+
+    template<typename F>
+    struct heapFunc {
+        static F*& get(storage_type& s) {
+            return *reinterpret_cast<F**>(&s);
+        }
+        static void invoke(storage_type& s) {
+            (*get(s))();
+        }
+        static void move(storage_type& dst, storage_type& src) {
+            new (&dst) F*(get(src));
+        }
+        static void destroy(storage_type& s) {
+            delete get(s);
+        }
+        static const vtable* table() {
+            static const vtable vt = {&invoke, &move, &destroy};
+            return &vt;
+        }
+    };
+
+    template<typename F>
+    struct isInline : std::integral_constant<bool,
+            sizeof(F) <= InlineSize
+            && alignof(storage_type) % alignof(F) == 0
+            && std::is_nothrow_move_constructible<F>::value> {};
+
+    storage_type m_storage;
+    const vtable* m_vtable;
+
+public:
+    BasicTask() : m_vtable(nullptr) {}
+
+    template<typename F, typename = typename std::enable_if<
+            !std::is_same<typename std::decay<F>::type, BasicTask>::value>::type>
+    BasicTask(F&& func) : m_vtable(nullptr) {
+        if (!BasicTask::isEmpty(func)) { // an empty std::function or a null pointer makes an empty task
+            assign(std::forward<F>(func), isInline<typename std::decay<F>::type>());
+        }
+    }
+
+    BasicTask(BasicTask&& other) noexcept : m_vtable(other.m_vtable) {
+        if (m_vtable != nullptr) {
+            m_vtable->move(m_storage, other.m_storage);
+            other.m_vtable = nullptr;
+        }
+    }
+
+    BasicTask& operator=(BasicTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.m_vtable != nullptr) {
+                other.m_vtable->move(m_storage, other.m_storage);
+                m_vtable = other.m_vtable;
+                other.m_vtable = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    ~BasicTask() {
+        reset();
+    }
+
+    BasicTask(const BasicTask&) = delete;
+    BasicTask& operator=(const BasicTask&) = delete;
+
+    explicit operator bool() const {
+        return m_vtable != nullptr;
+    }
+
+    void operator()() {
+        m_vtable->invoke(m_storage);
+    }
+
+    void reset() {
+        if (m_vtable != nullptr) {
+            m_vtable->destroy(m_storage);
+            m_vtable = nullptr;
+        }
+    }
+
+private:
+    template<typename F>
+    static bool isEmpty(const F&) {
+        return false;
+    }
+
+    template<typename F>
+    static bool isEmpty(F* func) {
+        return func == nullptr;
+    }
+
+    template<typename Signature>
+    static bool isEmpty(const std::function<Signature>& func) {
+        return !func;
+    }
+
+    template<typename F>
+    void assign(F&& func, std::true_type) {
+        typedef typename std::decay<F>::type func_type;
+        new (&m_storage) func_type(std::forward<F>(func));
+        m_vtable = inlineFunc<func_type>::table();
+    }
+
+    template<typename F>
+    void assign(F&& func, std::false_type) {
+        typedef typename std::decay<F>::type func_type;
+        new (&m_storage) func_type*(new func_type(std::forward<F>(func)));
+        m_vtable = heapFunc<func_type>::table();
+    }
+};
+
+// 56 bytes of inline storage keep the whole task within a 64-byte cache line.
+using Task = BasicTask<56>;
+
+} // namespace ccl
@@ -2,62 +2,590 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <algorithm>
 #include <atomic>
-#include <functional>
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 #include "ccl/blocking_queue.h"
+#include "ccl/histogram.h"
+#include "ccl/ring_buffer_queue.h"
+#include "ccl/task.h"
+#include "ccl/trace.h"
+#include "ccl/work_stealing_deque.h"
 
 namespace ccl {
 
-class ThreadPool final {
+enum class DispatchMode {
+    SharedQueue, // all workers pop from one queue
+    WorkStealing, // each worker owns a deque and steals from the others when idle
+};
+
+// Collects nothing. The hooks are empty and inlined away, so a pool without
+// metrics pays nothing for them.
+struct NoMetrics {
+    typedef int64_t timestamp;
+
+    void Start(size_t) {}
+    void BindWorker(size_t) {}
+    timestamp Now() const { return 0; }
+    void OnDispatch(Task&) {}
+    timestamp OnStart() { return 0; }
+    void OnRun(timestamp) {}
+    void OnIdle(timestamp) {}
+    void OnSteal() {}
+};
+
+// A point-in-time view of ThreadPoolMetrics. Durations are in nanoseconds.
+struct ThreadPoolStats {
+    struct Worker {
+        uint64_t tasksStarted;
+        uint64_t tasksRun; // finished
+        uint64_t steals;
+        uint64_t busyTime; // running tasks
+        uint64_t idleTime; // waiting for tasks
+        Histogram waitTime; // from Dispatch until the task starts, sampled
+        Histogram runTime;
+
+        double Utilization() const {
+            uint64_t total = busyTime + idleTime;
+            return total != 0 ? static_cast<double>(busyTime) / total : 0;
+        }
+    };
+
+    uint64_t dispatched;
+    uint64_t queueDepth; // dispatched tasks that have not started
+    std::vector<Worker> workers;
+    Worker total; // the sum over the workers
+
+    double Utilization() const {
+        return total.Utilization();
+    }
+};
+
+// Collects per-worker statistics of a BasicThreadPool<Queue, ThreadPoolMetrics>.
+// Every worker writes only its own counters, which are padded to separate
+// cache lines, and Snapshot reads them without stopping the workers.
+// A task would have to grow beyond the inline size of Task to carry its
+// dispatch time, so only every kWaitSampleInterval-th task per dispatching
+// thread is timed from Dispatch until it starts.
+class ThreadPoolMetrics final {
+public:
+    typedef int64_t timestamp; // [ns]
+
+    static const unsigned int kWaitSampleInterval = 16;
+
+private:
+    static const size_t kCacheLineSize = 64;
+
+    struct workerStats {
+        char pad0[kCacheLineSize];
+        std::atomic<uint64_t> tasksStarted;
+        std::atomic<uint64_t> tasksRun;
+        std::atomic<uint64_t> steals;
+        std::atomic<uint64_t> busyTime;
+        std::atomic<uint64_t> idleTime;
+        AtomicHistogram waitTime;
+        AtomicHistogram runTime;
+        char pad1[kCacheLineSize];
+
+        workerStats() : tasksStarted(0), tasksRun(0), steals(0), busyTime(0), idleTime(0) {}
+    };
+
+    struct timedTask {
+        Task task;
+        timestamp dispatched;
+
+        void operator()() {
+            workerStats* stats = current();
+            if (stats != nullptr) {
+                stats->waitTime.Record(static_cast<uint64_t>(now() - dispatched));
+            }
+            task();
+        }
+    };
+
+    std::vector<std::unique_ptr<workerStats>> m_workers;
+    char m_pad0[kCacheLineSize];
+    std::atomic<uint64_t> m_dispatched;
+    char m_pad1[kCacheLineSize];
+
+public:
+    ThreadPoolMetrics() : m_dispatched(0) {}
+
+    ThreadPoolMetrics(const ThreadPoolMetrics&) = delete;
+    ThreadPoolMetrics& operator=(const ThreadPoolMetrics&) = delete;
+
+    // Called by the pool before it starts the workers.
+    void Start(size_t nthreads) {
+        for (size_t i = 0; i < nthreads; i++) {
+            m_workers.emplace_back(new workerStats());
+        }
+    }
+
+    // Called on the worker thread before it takes the first task.
+    void BindWorker(size_t index) {
+        current() = m_workers[index].get();
+    }
+
+    timestamp Now() const {
+        return now();
+    }
+
+    void OnDispatch(Task& task) {
+        m_dispatched.fetch_add(1, std::memory_order_relaxed);
+        static thread_local unsigned int dispatches = 0;
+        if (dispatches++ % kWaitSampleInterval == 0) {
+            task = Task(timedTask{std::move(task), now()});
+        }
+    }
+
+    // A task is about to run. Returns its start time for OnRun.
+    timestamp OnStart() {
+        add(current()->tasksStarted, 1);
+        return now();
+    }
+
+    // A task that started at the given time has finished.
+    void OnRun(timestamp start) {
+        workerStats* stats = current();
+        uint64_t elapsed = static_cast<uint64_t>(now() - start);
+        add(stats->tasksRun, 1);
+        add(stats->busyTime, elapsed);
+        stats->runTime.Record(elapsed);
+    }
+
+    // The worker has waited for tasks since the given time.
+    void OnIdle(timestamp since) {
+        add(current()->idleTime, static_cast<uint64_t>(now() - since));
+    }
+
+    void OnSteal() {
+        add(current()->steals, 1);
+    }
+
+    ThreadPoolStats Snapshot() const {
+        ThreadPoolStats stats;
+        stats.total = ThreadPoolStats::Worker();
+        for (auto& w : m_workers) {
+            ThreadPoolStats::Worker worker;
+            worker.tasksStarted = w->tasksStarted.load(std::memory_order_relaxed);
+            worker.tasksRun = w->tasksRun.load(std::memory_order_relaxed);
+            worker.steals = w->steals.load(std::memory_order_relaxed);
+            worker.busyTime = w->busyTime.load(std::memory_order_relaxed);
+            worker.idleTime = w->idleTime.load(std::memory_order_relaxed);
+            w->waitTime.AddTo(&worker.waitTime);
+            w->runTime.AddTo(&worker.runTime);
+            stats.total.tasksStarted += worker.tasksStarted;
+            stats.total.tasksRun += worker.tasksRun;
+            stats.total.steals += worker.steals;
+            stats.total.busyTime += worker.busyTime;
+            stats.total.idleTime += worker.idleTime;
+            stats.total.waitTime.Merge(worker.waitTime);
+            stats.total.runTime.Merge(worker.runTime);
+            stats.workers.push_back(worker);
+        }
+        // Read after the workers, since a task is counted as dispatched before it can start.
+        stats.dispatched = m_dispatched.load(std::memory_order_relaxed);
+        uint64_t started = stats.total.tasksStarted;
+        stats.queueDepth = stats.dispatched > started ? stats.dispatched - started : 0;
+        return stats;
+    }
+
 private:
-    const std::function<void()> m_poison;
+    static timestamp now() {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    static workerStats*& current() {
+        static thread_local workerStats* stats = nullptr;
+        return stats;
+    }
+
+    // Only the owning worker writes its counters.
+    static void add(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+// Queue selects the task queue backend, e.g. BlockingQueue or RingBufferQueue.
+// Metrics selects the statistics collector, NoMetrics or ThreadPoolMetrics.
+// In the work-stealing mode the queue is used as the injection queue for tasks
+// dispatched from outside the pool, while tasks dispatched from a worker go to
+// the worker's own deque and run in LIFO order.
+template<typename Queue = BlockingQueue<Task>, typename Metrics = NoMetrics>
+class BasicThreadPool final {
+private:
+    // The state word holds the lifecycle bits and, above them, the number of
+    // Dispatch calls in progress. Shutdown waits for those calls to finish,
+    // so no task can be queued after the workers were told to exit.
+    static const uint64_t kShutdownBit = 1;
+    static const uint64_t kStopBit = 2;
+    static const uint64_t kTerminatedBit = 4;
+    static const uint64_t kDispatcherUnit = 8;
+    static const size_t kSpareTaskCount = 256; // per worker
+
+    struct worker {
+        BasicThreadPool* pool;
+        WorkStealingDeque<Task*> deque;
+        uint32_t random;
+        // The deque holds pointers, so the task nodes are recycled here to
+        // spawn tasks without allocating. Only the worker's thread uses them.
+        std::vector<std::unique_ptr<Task>> spareTasks;
+    };
+
+    const DispatchMode m_mode;
     std::vector<std::thread> m_threads;
-    BlockingQueue<std::function<void()>> m_queue;
+    std::vector<std::unique_ptr<worker>> m_workers;
+    Queue m_queue;
+    std::atomic<uint64_t> m_state;
+    std::atomic<size_t> m_liveThreads;
     std::atomic<bool> m_shutdownNow;
+    std::atomic<size_t> m_batchSize;
+    std::atomic<uint64_t> m_epoch; // incremented whenever work-stealing workers get a new task
+    std::atomic<int> m_sleepers;
+    std::mutex m_idleMutex;
+    std::condition_variable m_idleCondition;
+    std::mutex m_terminationMutex;
+    std::condition_variable m_terminationCondition;
+    Metrics m_metrics;
 
 public:
-    explicit ThreadPool(size_t nthreads, size_t queueCapacity = SIZE_MAX)
-            : m_queue(queueCapacity), m_shutdownNow(false) {
+    explicit BasicThreadPool(size_t nthreads, size_t queueCapacity = SIZE_MAX,
+            DispatchMode mode = DispatchMode::SharedQueue)
+            : m_mode(mode), m_queue(queueCapacity), m_state(0), m_liveThreads(nthreads)
+            , m_shutdownNow(false), m_batchSize(1), m_epoch(0), m_sleepers(0) {
+        m_metrics.Start(nthreads);
+        if (m_mode == DispatchMode::WorkStealing) {
+            for (size_t i = 0; i < nthreads; i++) {
+                m_workers.emplace_back(new worker{this, {}, static_cast<uint32_t>(i * 2654435761u + 1), {}});
+                m_workers.back()->spareTasks.reserve(kSpareTaskCount);
+            }
+            for (size_t i = 0; i < nthreads; i++) {
+                worker* w = m_workers[i].get();
+                m_threads.emplace_back([this, w, i]() {
+                    CCL_TRACE_THREAD_NAME("ccl::ThreadPool worker");
+                    m_metrics.BindWorker(i);
+                    runWorkStealing(w);
+                });
+            }
+            return;
+        }
         for (size_t i = 0; i < nthreads; i++) {
-            auto worker = [this]() {
+            auto worker = [this, i]() {
+                CCL_TRACE_THREAD_NAME("ccl::ThreadPool worker");
+                m_metrics.BindWorker(i);
+                std::vector<Task> batch;
                 while (true) {
-                    std::function<void()> task = m_queue.Pop();
-                    if (task.target_type() == m_poison.target_type()) {
-                        return;
+                    auto idleSince = m_metrics.Now();
+                    {
+                        CCL_TRACE_SCOPE("ThreadPool::Wait");
+                        m_queue.DrainTo(std::back_inserter(batch), m_batchSize.load(std::memory_order_relaxed));
+                    }
+                    m_metrics.OnIdle(idleSince);
+                    size_t wakeUps = 0;
+                    for (Task& task : batch) {
+                        if (task) {
+                            CCL_TRACE_SCOPE("ThreadPool::Run");
+                            auto start = m_metrics.OnStart();
+                            task();
+                            m_metrics.OnRun(start);
+                        } else { // woken up by shutdown
+                            wakeUps++;
+                        }
+                    }
+                    batch.clear();
+                    if (wakeUps > 0) {
+                        // Hand the extra wake-ups back to the other workers.
+                        for (size_t i = 1; i < wakeUps; i++) {
+                            m_queue.Push(Task());
+                        }
+                        break;
                     }
-                    task();
                 }
+                exitWorker();
             };
             m_threads.emplace_back(worker);
         }
     }
 
-    ~ThreadPool() {
+    // Runs the queued tasks and joins the workers, or discards the queued
+    // tasks first when SetShutdownNow(true) was called.
+    ~BasicThreadPool() {
         if (m_shutdownNow) {
-            m_queue.Clear();
-        }
-        for (size_t i = 0, n = m_threads.size(); i < n; i++) {
-            m_queue.Push(m_poison);
+            ShutdownNow();
+        } else {
+            Shutdown();
         }
         for (std::thread& th : m_threads) {
             th.join();
         }
+        for (auto& w : m_workers) {
+            Task* task;
+            while (w->deque.Pop(&task)) {
+                delete task;
+            }
+        }
     }
 
-    ThreadPool(const ThreadPool&) = delete;
-    ThreadPool& operator=(const ThreadPool&) = delete;
+    BasicThreadPool(const BasicThreadPool&) = delete;
+    BasicThreadPool& operator=(const BasicThreadPool&) = delete;
 
-    void Dispatch(std::function<void()>&& task) {
-        if (task.target_type() != m_poison.target_type()) {
+    // Returns false if the task is empty or the pool has been shut down.
+    bool Dispatch(Task&& task) {
+        if (!task) {
+            return false;
+        }
+        uint64_t state = m_state.fetch_add(kDispatcherUnit);
+        if (state & kShutdownBit) {
+            m_state.fetch_sub(kDispatcherUnit);
+            return false;
+        }
+        m_metrics.OnDispatch(task);
+        CCL_TRACE_INSTANT("ThreadPool::Dispatch", 0);
+        if (m_mode == DispatchMode::SharedQueue) {
+            m_queue.Push(std::move(task));
+            m_state.fetch_sub(kDispatcherUnit);
+            return true;
+        }
+        worker* w = currentWorker();
+        if (w != nullptr && w->pool == this) {
+            w->deque.Push(newTask(w, std::move(task)));
+        } else {
             m_queue.Push(std::move(task));
         }
+        m_state.fetch_sub(kDispatcherUnit);
+        wakeWorker();
+        return true;
+    }
+
+    // Stops accepting new tasks. Tasks dispatched before are still executed.
+    // Does not wait for them; use AwaitTermination for that.
+    void Shutdown() {
+        uint64_t state = m_state.fetch_or(kShutdownBit);
+        if (state & kShutdownBit) {
+            return;
+        }
+        awaitDispatchers();
+        wakeWorkersToExit();
+    }
+
+    // Stops accepting new tasks and removes the queued tasks.
+    // Returns the tasks that were never started. Running tasks are not interrupted.
+    std::vector<Task> ShutdownNow() {
+        uint64_t state = m_state.fetch_or(kShutdownBit | kStopBit);
+        std::vector<Task> tasks;
+        if (state & kStopBit) {
+            return tasks;
+        }
+        awaitDispatchers();
+        m_queue.DrainTo(std::back_inserter(tasks), SIZE_MAX, std::chrono::milliseconds(0));
+        tasks.erase(std::remove_if(tasks.begin(), tasks.end(), [](const Task& task) { return !task; }),
+                tasks.end());
+        for (auto& w : m_workers) {
+            Task* stolen;
+            while (w->deque.Steal(&stolen)) {
+                tasks.push_back(std::move(*stolen));
+                delete stolen;
+            }
+        }
+        wakeWorkersToExit();
+        return tasks;
+    }
+
+    bool IsShutdown() const {
+        return (m_state.load() & kShutdownBit) != 0;
+    }
+
+    bool IsTerminated() const {
+        return (m_state.load() & kTerminatedBit) != 0;
     }
 
+    // Blocks until all workers have exited after a shutdown.
+    void AwaitTermination() {
+        std::unique_lock<std::mutex> lock(m_terminationMutex);
+        while (!IsTerminated()) {
+            m_terminationCondition.wait(lock);
+        }
+    }
+
+    // Returns false if the pool did not terminate within the timeout.
+    template<class Rep, class Period>
+    bool AwaitTermination(const std::chrono::duration<Rep, Period>& timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(m_terminationMutex);
+        while (!IsTerminated()) {
+            if (m_terminationCondition.wait_until(lock, deadline) == std::cv_status::timeout) {
+                return IsTerminated();
+            }
+        }
+        return true;
+    }
+
+    // Sets how many tasks a shared-queue worker takes from the queue per wake-up.
+    // A larger batch saves queue operations for short tasks, but a taken batch
+    // always runs on the same worker and is not returned by ShutdownNow.
+    void SetBatchSize(size_t batchSize) {
+        m_batchSize = batchSize != 0 ? batchSize : 1;
+    }
+
+    // Makes the destructor call ShutdownNow instead of Shutdown.
     void SetShutdownNow(bool shutdownNow) {
         m_shutdownNow = shutdownNow;
     }
+
+    // Returns the statistics collected so far. Only available with ThreadPoolMetrics.
+    ThreadPoolStats Snapshot() const {
+        return m_metrics.Snapshot();
+    }
+
+private:
+    static worker*& currentWorker() {
+        static thread_local worker* current = nullptr;
+        return current;
+    }
+
+    void awaitDispatchers() {
+        while (m_state.load() >= kDispatcherUnit) {
+            std::this_thread::yield();
+        }
+    }
+
+    void wakeWorker() {
+        m_epoch.fetch_add(1);
+        if (m_sleepers.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_idleMutex);
+            m_idleCondition.notify_one();
+        }
+    }
+
+    void wakeWorkersToExit() {
+        if (m_threads.empty()) {
+            terminate();
+            return;
+        }
+        if (m_mode == DispatchMode::SharedQueue) {
+            // Empty tasks are queued behind every accepted task and make the workers exit.
+            for (size_t i = 0, n = m_threads.size(); i < n; i++) {
+                m_queue.Push(Task());
+            }
+            return;
+        }
+        m_epoch.fetch_add(1);
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_idleCondition.notify_all();
+    }
+
+    void exitWorker() {
+        if (m_liveThreads.fetch_sub(1) == 1) {
+            terminate();
+        }
+    }
+
+    void terminate() {
+        std::lock_guard<std::mutex> lock(m_terminationMutex);
+        m_state.fetch_or(kTerminatedBit);
+        m_terminationCondition.notify_all();
+    }
+
+    void runWorkStealing(worker* self) {
+        currentWorker() = self;
+        Task task;
+        while (true) {
+            uint64_t epoch = m_epoch.load();
+            uint64_t state = m_state.load();
+            if (state & kStopBit) {
+                break;
+            }
+            if (findTask(self, &task)) {
+                CCL_TRACE_SCOPE("ThreadPool::Run");
+                auto start = m_metrics.OnStart();
+                task();
+                m_metrics.OnRun(start);
+                task.reset();
+                continue;
+            }
+            // No dispatch can start after the shutdown and none was in progress,
+            // so the failed search above has seen every accepted task.
+            if ((state & kShutdownBit) && state < kDispatcherUnit) {
+                break;
+            }
+            // Sleep until another task is dispatched. The epoch is read before
+            // searching, so a task dispatched meanwhile prevents the sleep.
+            auto idleSince = m_metrics.Now();
+            CCL_TRACE_SCOPE("ThreadPool::Wait");
+            std::unique_lock<std::mutex> lock(m_idleMutex);
+            m_sleepers.fetch_add(1);
+            while (m_epoch.load() == epoch) {
+                m_idleCondition.wait(lock);
+            }
+            m_sleepers.fetch_sub(1);
+            lock.unlock();
+            m_metrics.OnIdle(idleSince);
+        }
+        exitWorker();
+    }
+
+    bool findTask(worker* self, Task* task) {
+        Task* found;
+        if (self->deque.Pop(&found)) {
+            takeTask(self, found, task);
+            return true;
+        }
+        if (m_queue.Pop(std::chrono::milliseconds(0), task) == std::cv_status::no_timeout) {
+            return true;
+        }
+        size_t n = m_workers.size();
+        size_t start = nextRandom(self) % n;
+        for (size_t i = 0; i < n; i++) {
+            worker* victim = m_workers[(start + i) % n].get();
+            if (victim != self && victim->deque.Steal(&found)) {
+                m_metrics.OnSteal();
+                CCL_TRACE_INSTANT("ThreadPool::Steal", 0);
+                takeTask(self, found, task);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Called by the worker's own thread.
+    static Task* newTask(worker* w, Task&& task) {
+        if (w->spareTasks.empty()) {
+            return new Task(std::move(task));
+        }
+        Task* node = w->spareTasks.back().release();
+        w->spareTasks.pop_back();
+        *node = std::move(task);
+        return node;
+    }
+
+    // Moves the task out of its node and keeps the node as a spare of self,
+    // which may not be the worker that allocated it.
+    static void takeTask(worker* self, Task* node, Task* task) {
+        *task = std::move(*node);
+        if (self->spareTasks.size() < kSpareTaskCount) {
+            self->spareTasks.emplace_back(node);
+        } else {
+            delete node;
+        }
+    }
+
+    static uint32_t nextRandom(worker* self) { // xorshift32
+        uint32_t x = self->random;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        self->random = x;
+        return x;
+    }
 };
 
+using ThreadPool = BasicThreadPool<>;
+
 } // namespace ccl
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Trace points in the library are compiled in only if CCL_ENABLE_TRACING is
+// defined, e.g. with -DCCL_ENABLE_TRACING for every translation unit.
+// Otherwise the macros below expand to nothing. Applications may use the
+// macros for their own trace points.
+//
+// Each thread records fixed-size events into its own ring buffer of
+// Tracer::kBufferCapacity events without locks, overwriting the oldest events
+// when full. Recording an event costs a clock read and a few stores. The
+// buffer of a thread that exited keeps its events until a new thread reuses it.
+// Tracer::WriteChromeTrace writes the recorded events in the Chrome
+// trace-event JSON format, which chrome://tracing and the Perfetto UI open.
+#ifdef CCL_ENABLE_TRACING
+ #define CCL_TRACE_CONCAT_(a, b) a##b
+ #define CCL_TRACE_CONCAT(a, b) CCL_TRACE_CONCAT_(a, b)
+ // Records the time until the end of the enclosing block. name must be a string literal.
+ #define CCL_TRACE_SCOPE(name) ::ccl::TraceScope CCL_TRACE_CONCAT(cclTraceScope, __LINE__)(name)
+ // Records a point in time with an argument, e.g. a size or an id.
+ #define CCL_TRACE_INSTANT(name, arg) ::ccl::Tracer::Instant(name, static_cast<uint64_t>(arg))
+ // Names the calling thread in the trace.
+ #define CCL_TRACE_THREAD_NAME(name) ::ccl::Tracer::SetThreadName(name)
+#else
+ #define CCL_TRACE_SCOPE(name) ((void) 0)
+ #define CCL_TRACE_INSTANT(name, arg) ((void) 0)
+ #define CCL_TRACE_THREAD_NAME(name) ((void) 0)
+#endif // CCL_ENABLE_TRACING
+
+namespace ccl {
+
+struct TraceEvent {
+    static const int64_t kInstant = -1; // the duration of an instant event
+
+    int64_t timestamp; // [ns] on the steady clock
+    int64_t duration; // [ns], or kInstant
+    const char* name;
+    uint64_t arg;
+};
+
+// The events recorded by one thread, oldest first.
+struct TraceThread {
+    uint32_t id;
+    std::string name;
+    std::vector<TraceEvent> events;
+};
+
+class Tracer final {
+public:
+    static const size_t kBufferCapacity = 1 << 14; // events per thread
+
+private:
+    // The fields are relaxed atomics, so that Collect may read a slot while
+    // its thread overwrites it. Such events are detected and dropped.
+    struct slot {
+        std::atomic<int64_t> timestamp;
+        std::atomic<int64_t> duration;
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> arg;
+    };
+
+    // Written by its thread only, like a seqlock: the claimed count is
+    // raised before a slot is overwritten and the published count after.
+    struct threadBuffer {
+        uint32_t id; // guarded by the registry mutex
+        bool live; // guarded by the registry mutex
+        std::atomic<uint64_t> claimed;
+        std::atomic<uint64_t> published; // the number of events recorded
+        slot slots[kBufferCapacity];
+        std::mutex nameMutex;
+        std::string name;
+
+        explicit threadBuffer(uint32_t id) : id(id), live(true), claimed(0), published(0) {}
+    };
+
+    struct registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<threadBuffer>> buffers;
+        uint32_t nextId;
+        std::atomic<bool> enabled;
+
+        registry() : nextId(1), enabled(true) {}
+    };
+
+    // Hands the buffer back to the registry when its thread exits.
+    struct threadHandle {
+        threadBuffer* buffer;
+
+        threadHandle() : buffer(nullptr) {}
+
+        ~threadHandle() {
+            if (buffer != nullptr) {
+                registry& r = getRegistry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                buffer->live = false;
+            }
+        }
+    };
+
+public:
+    Tracer() = delete;
+
+    static int64_t Now() {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void Instant(const char* name, uint64_t arg = 0) {
+        if (IsEnabled()) {
+            record(Now(), TraceEvent::kInstant, name, arg);
+        }
+    }
+
+    // Records an event from start until now.
+    static void Complete(const char* name, int64_t start, uint64_t arg = 0) {
+        if (IsEnabled()) {
+            record(start, Now() - start, name, arg);
+        }
+    }
+
+    static void SetThreadName(const std::string& name) {
+        threadBuffer* buffer = current();
+        std::lock_guard<std::mutex> lock(buffer->nameMutex);
+        buffer->name = name;
+    }
+
+    // Turns recording on or off at run time. Enabled by default.
+    static void SetEnabled(bool enabled) {
+        getRegistry().enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    static bool IsEnabled() {
+        return getRegistry().enabled.load(std::memory_order_relaxed);
+    }
+
+    // Returns the events recorded so far by every thread. Threads may keep
+    // recording meanwhile; events they overwrite during the copy are left out.
+    static std::vector<TraceThread> Collect() {
+        std::vector<std::shared_ptr<threadBuffer>> buffers;
+        std::vector<TraceThread> threads;
+        {
+            registry& r = getRegistry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            buffers = r.buffers;
+            for (auto& buffer : buffers) {
+                threads.push_back(TraceThread{buffer->id, std::string(), std::vector<TraceEvent>()});
+            }
+        }
+        for (size_t b = 0; b < buffers.size(); b++) {
+            threadBuffer* buffer = buffers[b].get();
+            TraceThread& thread = threads[b];
+            {
+                std::lock_guard<std::mutex> lock(buffer->nameMutex);
+                thread.name = buffer->name;
+            }
+            uint64_t published = buffer->published.load(std::memory_order_acquire);
+            uint64_t first = published > kBufferCapacity ? published - kBufferCapacity : 0;
+            for (uint64_t i = first; i < published; i++) {
+                slot& s = buffer->slots[i % kBufferCapacity];
+                thread.events.push_back(TraceEvent{s.timestamp.load(std::memory_order_relaxed),
+                        s.duration.load(std::memory_order_relaxed), s.name.load(std::memory_order_relaxed),
+                        s.arg.load(std::memory_order_relaxed)});
+            }
+            // Drop the events whose slots were claimed for newer events while they were copied.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t claimed = buffer->claimed.load(std::memory_order_relaxed);
+            if (claimed > first + kBufferCapacity) {
+                size_t overwritten = static_cast<size_t>(std::min<uint64_t>(claimed - kBufferCapacity - first,
+                        thread.events.size()));
+                thread.events.erase(thread.events.begin(), thread.events.begin() + overwritten);
+            }
+        }
+        return threads;
+    }
+
+    // Forgets the events recorded so far. Must not run while threads record.
+    static void Clear() {
+        registry& r = getRegistry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& buffer : r.buffers) {
+            buffer->claimed.store(0, std::memory_order_relaxed);
+            buffer->published.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static void WriteChromeTrace(std::ostream& out) {
+        std::vector<TraceThread> threads = Collect();
+        int64_t origin = INT64_MAX; // the timestamps start at 0 for readability
+        for (auto& thread : threads) {
+            for (auto& e : thread.events) {
+                origin = std::min(origin, e.timestamp);
+            }
+        }
+        out << "{\"traceEvents\":[";
+        const char* separator = "\n";
+        for (auto& thread : threads) {
+            if (!thread.name.empty()) {
+                out << separator << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.id
+                        << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+                writeString(out, thread.name.c_str());
+                out << "}}";
+                separator = ",\n";
+            }
+            for (auto& e : thread.events) {
+                out << separator << "{\"name\":";
+                writeString(out, e.name);
+                out << ",\"pid\":1,\"tid\":" << thread.id << ",\"ts\":";
+                writeMicroseconds(out, e.timestamp - origin);
+                if (e.duration == TraceEvent::kInstant) {
+                    out << ",\"ph\":\"i\",\"s\":\"t\"";
+                } else {
+                    out << ",\"ph\":\"X\",\"dur\":";
+                    writeMicroseconds(out, e.duration);
+                }
+                out << ",\"args\":{\"arg\":" << e.arg << "}}";
+                separator = ",\n";
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    }
+
+    // Returns false if the file cannot be written.
+    static bool WriteChromeTrace(const std::string& path) {
+        std::ofstream out(path);
+        if (!out) {
+            return false;
+        }
+        WriteChromeTrace(out);
+        return static_cast<bool>(out);
+    }
+
+private:
+    static registry& getRegistry() {
+        static registry r;
+        return r;
+    }
+
+    static threadBuffer* current() {
+        static thread_local threadHandle handle;
+        if (handle.buffer == nullptr) {
+            handle.buffer = acquireBuffer();
+        }
+        return handle.buffer;
+    }
+
+    // Reuses the buffer of an exited thread, or creates one.
+    static threadBuffer* acquireBuffer() {
+        registry& r = getRegistry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& buffer : r.buffers) {
+            if (!buffer->live) {
+                buffer->id = r.nextId++;
+                buffer->live = true;
+                buffer->claimed.store(0, std::memory_order_relaxed);
+                buffer->published.store(0, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> nameLock(buffer->nameMutex);
+                buffer->name.clear();
+                return buffer.get();
+            }
+        }
+        r.buffers.push_back(std::make_shared<threadBuffer>(r.nextId++));
+        return r.buffers.back().get();
+    }
+
+    static void record(int64_t timestamp, int64_t duration, const char* name, uint64_t arg) {
+        threadBuffer* buffer = current();
+        uint64_t index = buffer->published.load(std::memory_order_relaxed);
+        buffer->claimed.store(index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot& s = buffer->slots[index % kBufferCapacity];
+        s.timestamp.store(timestamp, std::memory_order_relaxed);
+        s.duration.store(duration, std::memory_order_relaxed);
+        s.name.store(name, std::memory_order_relaxed);
+        s.arg.store(arg, std::memory_order_relaxed);
+        buffer->published.store(index + 1, std::memory_order_release);
+    }
+
+    static void writeString(std::ostream& out, const char* s) {
+        out << '"';
+        for (; s != nullptr && *s != '\0'; s++) {
+            if (*s == '"' || *s == '\\') {
+                out << '\\' << *s;
+            } else if (static_cast<unsigned char>(*s) >= 0x20) {
+                out << *s;
+            }
+        }
+        out << '"';
+    }
+
+    static void writeMicroseconds(std::ostream& out, int64_t nanoseconds) {
+        char buf[32];
+        int n = snprintf(buf, sizeof(buf), "%lld.%03lld", static_cast<long long>(nanoseconds / 1000),
+                static_cast<long long>(nanoseconds % 1000));
+        out.write(buf, n);
+    }
+};
+
+// Records a complete event from its construction until its destruction.
+class TraceScope final {
+private:
+    const char* const m_name;
+    const int64_t m_start;
+
+public:
+    explicit TraceScope(const char* name) : m_name(name), m_start(Tracer::Now()) {}
+
+    ~TraceScope() {
+        Tracer::Complete(m_name, m_start);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+} // namespace ccl
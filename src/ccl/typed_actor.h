@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "ccl/actor_core.h"
+#include "ccl/thread_pool.h"
+
+namespace ccl {
+
+// Actor that accepts only the message types Msgs.
+// The handler is a callable overloaded for every message type, e.g. a struct
+// with operator()(int&) and operator()(Point&). The overload is selected at
+// compile time, and messages are stored by value in a tagged union inside
+// the same unbounded lock-free mailbox as Actor's, so sending needs neither
+// boxing nor RTTI, and never blocks.
+// Like Actor, the messages of one actor run one at a time on the pool.
+template<typename... Msgs>
+class TypedActor final {
+private:
+    static_assert(sizeof...(Msgs) > 0, "TypedActor needs at least one message type");
+
+    template<size_t...>
+    struct maxOf;
+
+    template<size_t N>
+    struct maxOf<N> : std::integral_constant<size_t, N> {};
+
+    template<size_t N, size_t M, size_t... Rest>
+    struct maxOf<N, M, Rest...> : maxOf<(N > M ? N : M), Rest...> {};
+
+    // The position of T in Ts, or sizeof...(Ts) if T is not one of them.
+    template<typename T, typename... Ts>
+    struct indexOf;
+
+    template<typename T>
+    struct indexOf<T> : std::integral_constant<size_t, 0> {};
+
+    template<typename T, typename... Ts>
+    struct indexOf<T, T, Ts...> : std::integral_constant<size_t, 0> {};
+
+    template<typename T, typename U, typename... Ts>
+    struct indexOf<T, U, Ts...> : std::integral_constant<size_t, 1 + indexOf<T, Ts...>::value> {};
+
+    typedef typename std::aligned_storage<maxOf<sizeof(Msgs)...>::value,
+            maxOf<alignof(Msgs)...>::value>::type storage_type;
+
+    // Tagged union of Msgs, or empty.
+    class message final {
+    private:
+        static const size_t kEmpty = sizeof...(Msgs);
+
+        storage_type m_storage;
+        size_t m_index;
+
+        template<typename T>
+        static void moveAs(storage_type& dst, storage_type& src) {
+            new (&dst) T(std::move(*reinterpret_cast<T*>(&src)));
+        }
+
+        template<typename T>
+        static void destroyAs(storage_type& s) {
+            reinterpret_cast<T*>(&s)->~T();
+        }
+
+    public:
+        message() : m_index(kEmpty) {}
+
+        template<typename T, typename = typename std::enable_if<
+                !std::is_same<typename std::decay<T>::type, message>::value>::type>
+        explicit message(T&& value) : m_index(indexOf<typename std::decay<T>::type, Msgs...>::value) {
+            new (&m_storage) typename std::decay<T>::type(std::forward<T>(value));
+        }
+
+        message(message&& other) noexcept : m_index(kEmpty) {
+            *this = std::move(other);
+        }
+
+        message& operator=(message&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                if (other.m_index != kEmpty) {
+                    static void (*const move[])(storage_type&, storage_type&) = {&moveAs<Msgs>...};
+                    move[other.m_index](m_storage, other.m_storage);
+                    m_index = other.m_index;
+                    other.Reset();
+                }
+            }
+            return *this;
+        }
+
+        ~message() {
+            Reset();
+        }
+
+        message(const message&) = delete;
+        message& operator=(const message&) = delete;
+
+        size_t Index() const {
+            return m_index;
+        }
+
+        storage_type& Storage() {
+            return m_storage;
+        }
+
+        void Reset() {
+            if (m_index != kEmpty) {
+                static void (*const destroy[])(storage_type&) = {&destroyAs<Msgs>...};
+                destroy[m_index](m_storage);
+                m_index = kEmpty;
+            }
+        }
+    };
+
+    struct envelope {
+        message msg;
+        std::unique_ptr<std::promise<void>> promise; // null for Tell
+    };
+
+    class core : public actorCore<core, envelope> {
+    private:
+        friend class actorCore<core, envelope>;
+
+    public:
+        explicit core(ThreadPool* pool) : actorCore<core, envelope>(pool) {}
+
+        virtual ~core() = default;
+
+        void Post(envelope&& e) {
+            this->post(std::move(e));
+        }
+
+    protected:
+        virtual void receive(message& msg) = 0;
+
+    private:
+        void deliver(envelope& e) {
+            try {
+                receive(e.msg);
+                if (e.promise) {
+                    e.promise->set_value();
+                }
+            } catch (...) {
+                if (e.promise) {
+                    e.promise->set_exception(std::current_exception());
+                }
+            }
+            e.msg.Reset();
+        }
+    };
+
+    template<typename Handler>
+    class handlerCore final : public core {
+    private:
+        Handler m_handler;
+
+        template<typename T>
+        static void invoke(Handler& handler, storage_type& s) {
+            handler(*reinterpret_cast<T*>(&s));
+        }
+
+    public:
+        handlerCore(ThreadPool* pool, Handler&& handler)
+                : core(pool), m_handler(std::move(handler)) {}
+
+    protected:
+        void receive(message& msg) override {
+            static void (*const table[])(Handler&, storage_type&) = {&invoke<Msgs>...};
+            table[msg.Index()](m_handler, msg.Storage());
+        }
+    };
+
+    template<typename T>
+    struct accepts : std::integral_constant<bool,
+            indexOf<typename std::decay<T>::type, Msgs...>::value < sizeof...(Msgs)> {};
+
+    std::shared_ptr<ThreadPool> m_pool;
+    std::shared_ptr<core> m_core;
+    bool m_shutdownNow;
+
+public:
+    template<typename Handler>
+    explicit TypedActor(Handler handler)
+            : m_pool(std::make_shared<ThreadPool>(1))
+            , m_core(std::make_shared<handlerCore<Handler>>(m_pool.get(), std::move(handler)))
+            , m_shutdownNow(false) {}
+
+    template<typename Handler>
+    TypedActor(const std::shared_ptr<ThreadPool>& pool, Handler handler)
+            : m_pool(pool)
+            , m_core(std::make_shared<handlerCore<Handler>>(m_pool.get(), std::move(handler)))
+            , m_shutdownNow(false) {}
+
+    // The messages already sent are still processed unless SetShutdownNow(true)
+    // was called, in which case the pending ones are discarded.
+    ~TypedActor() {
+        if (m_shutdownNow) {
+            m_core->Stop();
+        }
+    }
+
+    TypedActor(const TypedActor&) = delete;
+    TypedActor& operator=(const TypedActor&) = delete;
+
+    // The future becomes ready when the handler has returned, or holds its exception.
+    template<typename T>
+    std::future<void> Send(T&& msg) {
+        static_assert(accepts<T>::value, "the message type is not accepted by this actor");
+        envelope e;
+        e.msg = message(std::forward<T>(msg));
+        e.promise.reset(new std::promise<void>());
+        std::future<void> future = e.promise->get_future();
+        m_core->Post(std::move(e));
+        return future;
+    }
+
+    // Sends a message without a response. Exceptions of the handler are discarded.
+    template<typename T>
+    void Tell(T&& msg) {
+        static_assert(accepts<T>::value, "the message type is not accepted by this actor");
+        envelope e;
+        e.msg = message(std::forward<T>(msg));
+        m_core->Post(std::move(e));
+    }
+
+    // Sets how many messages are processed per dispatch before the worker
+    // is handed to other tasks of the pool.
+    void SetThroughput(size_t throughput) {
+        m_core->SetThroughput(throughput);
+    }
+
+    void SetShutdownNow(bool shutdownNow) {
+        m_shutdownNow = shutdownNow;
+        m_pool->SetShutdownNow(shutdownNow);
+    }
+};
+
+} // namespace ccl
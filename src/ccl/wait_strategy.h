@@ -0,0 +1,205 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace ccl {
+
+// A wait strategy decides how a thread waits for a condition guarded by a
+// mutex. It provides
+//
+//     template<typename Predicate[, typename Probe]>
+//     static void Wait(std::unique_lock<std::mutex>& lock,
+//             std::condition_variable& condition, Predicate pred[, Probe probe]);
+//
+//     template<class Clock, class Duration, typename Predicate[, typename Probe]>
+//     static bool WaitUntil(std::unique_lock<std::mutex>& lock,
+//             std::condition_variable& condition,
+//             const std::chrono::time_point<Clock, Duration>& deadline,
+//             Predicate pred[, Probe probe]);
+//
+// which return once pred() is true, always evaluated with the lock held.
+// WaitUntil returns the value of pred() at the deadline. The notifying side
+// notifies the condition as usual, so the strategies differ only in how long
+// a waiter stays awake before it sleeps on the condition.
+// The probe is an optional check of the same condition that is safe to call
+// without the lock, e.g. an atomic load. A spinning strategy spins on the
+// probe with the lock released, so that the notifier never finds the mutex
+// taken, and takes the lock again once to confirm with pred. Without a probe
+// it takes the lock to check pred at spins 1, 2, 4, ... and then every 64th.
+
+// Tells the CPU that the thread is spinning, e.g. with the x86 PAUSE instruction.
+inline void cpuRelax() {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    __builtin_ia32_pause();
+#elif defined(__GNUC__) && (defined(__aarch64__) || defined(__arm__))
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// The probe of a spinning wait without a lock-free one: checks pred under
+// the lock at exponentially growing intervals of spins.
+template<typename Predicate>
+class lockedProbe final {
+private:
+    static const unsigned int kMaxInterval = 64;
+
+    std::mutex& m_mutex;
+    Predicate& m_pred;
+    unsigned int m_spins;
+    unsigned int m_next; // the spin at which pred is checked next
+
+public:
+    lockedProbe(std::mutex& mutex, Predicate& pred) : m_mutex(mutex), m_pred(pred), m_spins(0), m_next(1) {}
+
+    bool operator()() {
+        if (++m_spins < m_next) {
+            return false;
+        }
+        m_next = m_spins + (m_spins < kMaxInterval ? m_spins : kMaxInterval);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pred();
+    }
+};
+
+// Sleeps on the condition variable right away. Cheapest for the CPU, but
+// every hand-off pays for a sleep and a wake-up of the waiting thread.
+struct BlockingWait {
+    template<typename Predicate>
+    static void Wait(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, Predicate pred) {
+        condition.wait(lock, pred);
+    }
+
+    template<typename Predicate, typename Probe>
+    static void Wait(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, Predicate pred,
+            Probe) {
+        condition.wait(lock, pred);
+    }
+
+    template<class Clock, class Duration, typename Predicate>
+    static bool WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& condition,
+            const std::chrono::time_point<Clock, Duration>& deadline, Predicate pred) {
+        return condition.wait_until(lock, deadline, pred);
+    }
+
+    template<class Clock, class Duration, typename Predicate, typename Probe>
+    static bool WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& condition,
+            const std::chrono::time_point<Clock, Duration>& deadline, Predicate pred, Probe) {
+        return condition.wait_until(lock, deadline, pred);
+    }
+};
+
+// Checks the condition SpinCount times with a pause in between, then
+// YieldCount times yielding the CPU, and only then sleeps on the condition
+// variable. Hand-offs that complete within microseconds never sleep.
+template<unsigned int SpinCount = 128, unsigned int YieldCount = 16>
+struct SpinThenParkWait {
+    template<typename Predicate>
+    static void Wait(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, Predicate pred) {
+        Wait(lock, condition, pred, lockedProbe<Predicate>(*lock.mutex(), pred));
+    }
+
+    template<typename Predicate, typename Probe>
+    static void Wait(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, Predicate pred,
+            Probe probe) {
+        if (pred()) {
+            return;
+        }
+        spin(lock, probe, []() { return false; });
+        condition.wait(lock, pred);
+    }
+
+    template<class Clock, class Duration, typename Predicate>
+    static bool WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& condition,
+            const std::chrono::time_point<Clock, Duration>& deadline, Predicate pred) {
+        return WaitUntil(lock, condition, deadline, pred, lockedProbe<Predicate>(*lock.mutex(), pred));
+    }
+
+    template<class Clock, class Duration, typename Predicate, typename Probe>
+    static bool WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& condition,
+            const std::chrono::time_point<Clock, Duration>& deadline, Predicate pred, Probe probe) {
+        if (pred()) {
+            return true;
+        }
+        spin(lock, probe, [&deadline]() { return Clock::now() >= deadline; });
+        return condition.wait_until(lock, deadline, pred);
+    }
+
+private:
+    static const unsigned int kClockInterval = 16; // pauses between two reads of the clock
+
+    // Spins with the lock released until the probe succeeds, the spins run
+    // out or the deadline has passed.
+    template<typename Probe, typename Expired>
+    static void spin(std::unique_lock<std::mutex>& lock, Probe& probe, Expired expired) {
+        lock.unlock();
+        for (unsigned int i = 0; i < SpinCount + YieldCount && !probe(); i++) {
+            if (i < SpinCount) {
+                if (i % kClockInterval == kClockInterval - 1 && expired()) {
+                    break;
+                }
+                cpuRelax();
+            } else { // a yield costs a system call anyway
+                if (expired()) {
+                    break;
+                }
+                std::this_thread::yield();
+            }
+        }
+        lock.lock();
+    }
+};
+
+// Never sleeps. Gives the lowest latency when every waiting thread has a
+// core of its own, and burns that core while waiting.
+struct BusySpinWait {
+    template<typename Predicate>
+    static void Wait(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, Predicate pred) {
+        Wait(lock, condition, pred, lockedProbe<Predicate>(*lock.mutex(), pred));
+    }
+
+    template<typename Predicate, typename Probe>
+    static void Wait(std::unique_lock<std::mutex>& lock, std::condition_variable&, Predicate pred, Probe probe) {
+        while (!pred()) {
+            lock.unlock();
+            while (!probe()) {
+                cpuRelax();
+            }
+            lock.lock();
+        }
+    }
+
+    template<class Clock, class Duration, typename Predicate>
+    static bool WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable& condition,
+            const std::chrono::time_point<Clock, Duration>& deadline, Predicate pred) {
+        return WaitUntil(lock, condition, deadline, pred, lockedProbe<Predicate>(*lock.mutex(), pred));
+    }
+
+    template<class Clock, class Duration, typename Predicate, typename Probe>
+    static bool WaitUntil(std::unique_lock<std::mutex>& lock, std::condition_variable&,
+            const std::chrono::time_point<Clock, Duration>& deadline, Predicate pred, Probe probe) {
+        while (!pred()) {
+            lock.unlock();
+            bool expired = false;
+            for (unsigned int i = 1; !probe(); i++) {
+                if (i % kClockInterval == 0 && Clock::now() >= deadline) {
+                    expired = true;
+                    break;
+                }
+                cpuRelax();
+            }
+            lock.lock();
+            if (expired) {
+                return pred();
+            }
+        }
+        return true;
+    }
+
+private:
+    static const unsigned int kClockInterval = 16; // pauses between two reads of the clock
+};
+
+} // namespace ccl
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace ccl {
+
+// Chase-Lev work-stealing deque.
+// Only the owner thread may call Push and Pop, which work on the bottom end
+// in LIFO order. Any thread may call Steal, which takes from the top end.
+// T must be trivially copyable, typically a pointer.
+template<typename T>
+class WorkStealingDeque final {
+private:
+    static const size_t kCacheLineSize = 64;
+    static const size_t kInitialCapacity = 64;
+
+    class ring {
+    private:
+        const int64_t m_capacity;
+        std::unique_ptr<std::atomic<T>[]> m_elements;
+
+    public:
+        explicit ring(int64_t capacity)
+                : m_capacity(capacity), m_elements(new std::atomic<T>[capacity]) {}
+
+        int64_t Capacity() const {
+            return m_capacity;
+        }
+
+        T Get(int64_t i) const {
+            return m_elements[i & (m_capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void Put(int64_t i, T element) {
+            m_elements[i & (m_capacity - 1)].store(element, std::memory_order_relaxed);
+        }
+
+        ring* Grow(int64_t bottom, int64_t top) const {
+            ring* grown = new ring(m_capacity * 2);
+            for (int64_t i = top; i < bottom; i++) {
+                grown->Put(i, Get(i));
+            }
+            return grown;
+        }
+    };
+
+    std::atomic<int64_t> m_top;
+    char m_pad[kCacheLineSize];
+    std::atomic<int64_t> m_bottom;
+    std::atomic<ring*> m_ring;
+    std::vector<std::unique_ptr<ring>> m_rings; // retired rings are freed with the deque
+
+public:
+    WorkStealingDeque() : m_top(0), m_bottom(0), m_ring(new ring(kInitialCapacity)) {
+        m_rings.emplace_back(m_ring.load(std::memory_order_relaxed));
+    }
+
+    ~WorkStealingDeque() = default;
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Returns an approximate size while other threads are stealing.
+    size_t Size() const {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    bool Empty() const {
+        return Size() == 0;
+    }
+
+    void Push(T element) {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_acquire);
+        ring* r = m_ring.load(std::memory_order_relaxed);
+        if (bottom - top > r->Capacity() - 1) {
+            r = r->Grow(bottom, top);
+            m_rings.emplace_back(r);
+            m_ring.store(r, std::memory_order_release);
+        }
+        r->Put(bottom, element);
+        m_bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    bool Pop(T* element) {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        ring* r = m_ring.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+        if (top > bottom) { // empty
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        *element = r->Get(bottom);
+        if (top == bottom) { // the last element races with thieves
+            bool won = m_top.compare_exchange_strong(top, top + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool Steal(T* element) {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom) { // empty
+            return false;
+        }
+        ring* r = m_ring.load(std::memory_order_acquire);
+        T stolen = r->Get(top);
+        if (!m_top.compare_exchange_strong(top, top + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false; // lost the race with another thief or the owner
+        }
+        *element = stolen;
+        return true;
+    }
+};
+
+} // namespace ccl
@@ -1,5 +1,9 @@
 #include "ccl/actor.h"
 #include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 #include "ccl/countdown_latch.h"
 #include "util.h"
@@ -26,6 +30,27 @@ TEST(Actor, Send) {
     EXPECT_EQ(sendMsg, recvMsg);
 }
 
+TEST(Actor, Tell) {
+    // setup:
+    const int sendCount = 100;
+    int sum = 0;
+    CountdownLatch latch(sendCount);
+
+    // when:
+    Actor actor([&](any& msg) -> any {
+        sum += any_cast<int>(msg);
+        latch.CountDown();
+        throw std::runtime_error("ignored");
+    });
+    for (int i = 1; i <= sendCount; i++) {
+        actor.Tell(i);
+    }
+    latch.Await();
+
+    // then:
+    EXPECT_EQ(sendCount * (sendCount + 1) / 2, sum);
+}
+
 TEST(Actor, ShutdownNow) {
     // setup:
     const int sendCount = 10000;
@@ -50,6 +75,149 @@ TEST(Actor, ShutdownNow) {
     EXPECT_NE(sendCount, sum);
 }
 
+TEST(Actor, Send_SharedPoolRunsMessagesSerially) {
+    // setup:
+    const int nactors = 100;
+    const int sendCount = 100;
+    std::atomic<int> overlaps(0);
+    std::vector<int> counts(nactors, 0);
+    std::vector<std::atomic<bool>> running(nactors);
+    for (auto& flag : running) {
+        flag = false;
+    }
+
+    // when:
+    auto pool = std::make_shared<ThreadPool>(4);
+    std::vector<std::unique_ptr<Actor>> actors;
+    for (int i = 0; i < nactors; i++) {
+        actors.emplace_back(new Actor(pool, [&, i](any& msg) {
+            if (running[i].exchange(true)) {
+                overlaps++;
+            }
+            counts[i]++; // not atomic: guarded by the actor's serial execution
+            running[i] = false;
+            return 0;
+        }));
+        actors.back()->SetThroughput(8);
+    }
+    for (int j = 0; j < sendCount; j++) {
+        for (auto& actor : actors) {
+            actor->Send(j);
+        }
+    }
+    actors.clear();
+    pool->Shutdown();
+    pool->AwaitTermination();
+
+    // then:
+    EXPECT_EQ(0, overlaps);
+    for (int count : counts) {
+        EXPECT_EQ(sendCount, count);
+    }
+}
+
+TEST(Actor, Send_ReturnsResponseInOrder) {
+    // setup:
+    const int sendCount = 1000;
+    auto pool = std::make_shared<ThreadPool>(4);
+    int received = 0;
+
+    // when:
+    Actor actor(pool, [&](any& msg) {
+        return received++;
+    });
+    std::vector<std::future<any>> futures;
+    for (int i = 0; i < sendCount; i++) {
+        futures.push_back(actor.Send(i));
+    }
+
+    // then:
+    for (int i = 0; i < sendCount; i++) {
+        EXPECT_EQ(i, any_cast<int>(futures[i].get()));
+    }
+}
+
+TEST(Actor, Send_PropagatesException) {
+    // when:
+    Actor actor([](any& msg) -> any {
+        throw std::runtime_error("error");
+    });
+    auto future = actor.Send(0);
+
+    // then:
+    EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+TEST(Actor, Ask) {
+    // setup:
+    Actor first([](any& msg) {
+        return any_cast<int>(msg) + 1;
+    });
+    Actor second([](any& msg) {
+        return any_cast<int>(msg) * 2;
+    });
+
+    // when: chain the replies of both actors
+    Future<any> reply = first.Ask(1).Then([&](any r) {
+        return second.Ask(std::move(r));
+    });
+
+    // then:
+    EXPECT_EQ(4, any_cast<int>(reply.Get()));
+}
+
+TEST(Actor, Ask_PropagatesException) {
+    // when:
+    Actor actor([](any& msg) -> any {
+        throw std::runtime_error("error");
+    });
+    auto future = actor.Ask(0);
+
+    // then:
+    EXPECT_THROW(future.Get(), std::runtime_error);
+}
+
+TEST(Actor, Stats) {
+    // setup:
+    const int messageCount = 10;
+    CountdownLatch started(1);
+    CountdownLatch release(1);
+
+    // when: the handler blocks on the first message while the others queue up
+    Actor actor([&](any& msg) {
+        if (any_cast<int>(msg) == 0) {
+            started.CountDown();
+            release.Await();
+        }
+        return msg;
+    });
+    std::vector<std::future<any>> futures;
+    for (int i = 0; i < messageCount; i++) {
+        futures.push_back(actor.Send(i));
+    }
+    started.Await();
+    ActorStats blocked = actor.Stats();
+    release.CountDown();
+    for (auto& future : futures) {
+        future.get();
+    }
+    util::Delay(); // until the last handler time is recorded
+    ActorStats stats = actor.Stats();
+
+    // then:
+    EXPECT_EQ(messageCount, blocked.received);
+    EXPECT_EQ(1, blocked.processed);
+    EXPECT_EQ(messageCount - 1, blocked.mailboxDepth);
+    EXPECT_LT(0, blocked.runningFor);
+
+    EXPECT_EQ(messageCount, stats.received);
+    EXPECT_EQ(messageCount, stats.processed);
+    EXPECT_EQ(0, stats.mailboxDepth);
+    EXPECT_LE(messageCount - 1, stats.highWaterMark);
+    EXPECT_EQ(0, stats.runningFor);
+    EXPECT_EQ(messageCount, stats.handlerTime.Count());
+}
+
 TEST(ActorNameSystem, Register) {
     // when:
     ActorNameSystem system;
@@ -88,3 +256,60 @@ TEST(ActorNameSystem, Unregister) {
     auto actor = system.Lookup("actor");
     EXPECT_EQ(nullptr, actor);
 }
+
+TEST(ActorNameSystem, GetHottest) {
+    // setup:
+    ActorNameSystem system;
+    auto idle = std::make_shared<Actor>([](any& msg) { return msg; });
+    auto busy = std::make_shared<Actor>([](any& msg) {
+        util::Delay();
+        return msg;
+    });
+    system.Register("idle", idle);
+    system.Register("busy", busy);
+
+    // when:
+    idle->Send(0).get();
+    busy->Send(0).get();
+    util::Delay();
+    auto hottest = system.GetHottest(1);
+
+    // then:
+    ASSERT_EQ(1, hottest.size());
+    EXPECT_EQ("busy", hottest[0].first);
+    EXPECT_EQ(1, hottest[0].second.processed);
+    EXPECT_EQ(2, system.GetHottest(10).size());
+}
+
+TEST(ActorNameSystem, StartWatchdog) {
+    // setup:
+    std::mutex mutex;
+    std::vector<std::string> reported;
+    CountdownLatch release(1);
+    ActorNameSystem system;
+    auto slow = std::make_shared<Actor>([&](any& msg) {
+        release.Await();
+        return msg;
+    });
+    auto fast = std::make_shared<Actor>([](any& msg) { return msg; });
+    system.Register("slow", slow);
+    system.Register("fast", fast);
+
+    // when:
+    system.StartWatchdog(std::chrono::milliseconds(5), [&](const std::string& name, std::chrono::nanoseconds running) {
+        std::lock_guard<std::mutex> lock(mutex);
+        reported.push_back(name);
+        EXPECT_LT(std::chrono::milliseconds(5), running);
+    });
+    auto future = slow->Send(0);
+    fast->Send(0).get();
+    util::DoHeavyTask();
+    release.CountDown();
+    future.get();
+    system.StopWatchdog();
+
+    // then: reported once
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(1, reported.size());
+    EXPECT_EQ("slow", reported[0]);
+}
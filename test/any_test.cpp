@@ -0,0 +1,236 @@
+#include "ccl/any.h"
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "util.h"
+
+using namespace ccl;
+
+namespace {
+
+std::atomic<size_t> allocations(0);
+
+struct Large {
+    long values[8];
+};
+
+} // namespace
+
+// Counts the allocations of this test binary. Not inlined, so that GCC does
+// not mistake free for a mismatched deallocation.
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size != 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+TEST(Any, Empty) {
+    // when:
+    any value;
+
+    // then:
+    EXPECT_TRUE(value.empty());
+    EXPECT_EQ(typeid(void), value.type());
+    EXPECT_EQ(nullptr, any_cast<int>(&value));
+}
+
+TEST(Any, AnyCast_SmallValue) {
+    // when:
+    any value = 1;
+
+    // then:
+    EXPECT_FALSE(value.empty());
+    EXPECT_EQ(typeid(int), value.type());
+    EXPECT_EQ(1, any_cast<int>(value));
+    EXPECT_EQ(nullptr, any_cast<long>(&value));
+    EXPECT_THROW(any_cast<long>(value), bad_any_cast);
+}
+
+TEST(Any, AnyCast_LargeValue) {
+    // when:
+    any value = Large{{1, 2, 3, 4, 5, 6, 7, 8}};
+
+    // then:
+    EXPECT_EQ(typeid(Large), value.type());
+    EXPECT_EQ(8, any_cast<Large&>(value).values[7]);
+}
+
+TEST(Any, AnyCast_Const) {
+    // when:
+    const any value = std::string("value");
+
+    // then:
+    EXPECT_EQ("value", any_cast<const std::string&>(value));
+    EXPECT_NE(nullptr, any_cast<std::string>(&value));
+}
+
+TEST(Any, Copy_SharesNothing) {
+    // setup:
+    std::vector<int> vec = {1, 2, 3};
+
+    // when:
+    any value1 = vec;
+    any value2 = value1;
+    any_cast<std::vector<int>&>(value2).push_back(4);
+
+    // then:
+    EXPECT_EQ(3, any_cast<std::vector<int>&>(value1).size());
+    EXPECT_EQ(4, any_cast<std::vector<int>&>(value2).size());
+}
+
+TEST(Any, Copy_SharedPtr) {
+    // setup:
+    auto ptr = std::make_shared<int>(1);
+
+    // when:
+    {
+        any value1 = ptr;
+        any value2 = value1;
+
+        // then:
+        EXPECT_EQ(3, ptr.use_count());
+    }
+
+    // then:
+    EXPECT_EQ(1, ptr.use_count());
+}
+
+TEST(Any, Move) {
+    // when:
+    any value1 = std::string("value");
+    any value2 = std::move(value1);
+
+    // then:
+    EXPECT_TRUE(value1.empty());
+    EXPECT_EQ("value", any_cast<std::string>(value2));
+}
+
+TEST(Any, Move_LargeValueKeepsAddress) {
+    // when:
+    any value1 = Large{};
+    Large* held = any_cast<Large>(&value1);
+    any value2 = std::move(value1);
+
+    // then:
+    EXPECT_EQ(held, any_cast<Large>(&value2));
+}
+
+TEST(Any, Swap_SmallAndLarge) {
+    // when:
+    any value1 = 1;
+    any value2 = Large{{2}};
+    value1.swap(value2);
+
+    // then:
+    EXPECT_EQ(2, any_cast<Large&>(value1).values[0]);
+    EXPECT_EQ(1, any_cast<int>(value2));
+}
+
+TEST(Any, Assign) {
+    // when:
+    any value = 1;
+    value = std::string("value");
+
+    // then:
+    EXPECT_EQ("value", any_cast<std::string>(value));
+
+    // when:
+    value.clear();
+
+    // then:
+    EXPECT_TRUE(value.empty());
+}
+
+TEST(Any, Shared_CopiesShareValue) {
+    // when:
+    any value = Large{{1}};
+    any shared1 = value.shared();
+    any shared2 = shared1;
+
+    // then:
+    EXPECT_NE(any_cast<const Large>(&value), any_cast<const Large>(&shared1));
+    EXPECT_EQ(any_cast<const Large>(&shared1), any_cast<const Large>(&shared2));
+    EXPECT_EQ(1, any_cast<Large>(shared2).values[0]);
+    EXPECT_EQ(1, any_cast<const Large&>(shared2).values[0]);
+    EXPECT_EQ(any_cast<const Large>(&shared1), any_cast<const Large>(&shared2));
+}
+
+TEST(Any, Shared_SmallNonTrivialValue) {
+    // when: a string fits inline, but copying it copies its characters
+    any shared1 = any(std::string(100, 'a')).shared();
+    any shared2 = shared1;
+
+    // then:
+    EXPECT_EQ(any_cast<const std::string>(&shared1), any_cast<const std::string>(&shared2));
+    EXPECT_EQ(std::string(100, 'a'), any_cast<std::string>(shared2));
+}
+
+TEST(Any, Shared_CopyOnWrite) {
+    // when:
+    any shared1 = any(std::vector<int>(100, 1)).shared();
+    any shared2 = shared1;
+    const std::vector<int>* before = any_cast<const std::vector<int>>(&shared1);
+    any_cast<std::vector<int>&>(shared2)[0] = 2;
+
+    // then:
+    EXPECT_EQ(before, any_cast<const std::vector<int>>(&shared1));
+    EXPECT_EQ(1, any_cast<const std::vector<int>&>(shared1)[0]);
+    EXPECT_EQ(2, any_cast<const std::vector<int>&>(shared2)[0]);
+
+    // when: the last owner writes in place
+    std::vector<int>* owned = any_cast<std::vector<int>>(&shared2);
+
+    // then:
+    EXPECT_EQ(owned, any_cast<std::vector<int>>(&shared2));
+}
+
+TEST(Any, Shared_SmallValue) {
+    // when:
+    any value = 1;
+    any shared = value.shared();
+
+    // then:
+    EXPECT_EQ(typeid(int), shared.type());
+    EXPECT_EQ(1, any_cast<int>(shared));
+}
+
+TEST(Any, Shared_SharedPtrDoesNotAllocate) {
+    // setup:
+    auto ptr = std::make_shared<std::vector<char>>(1024);
+    any value = ptr;
+    std::vector<any> received(16);
+    size_t before = allocations.load();
+
+    // when: share it as PubSub does for each subscriber
+    any shared = value.shared();
+    for (auto& r : received) {
+        r = shared;
+    }
+
+    // then:
+    EXPECT_EQ(before, allocations.load());
+    EXPECT_EQ(ptr, any_cast<std::shared_ptr<std::vector<char>>>(received.back()));
+}
+
+TEST(Any, Shared_Rvalue) {
+    // when:
+    any value = Large{};
+    Large* held = any_cast<Large>(&value);
+    any shared = std::move(value).shared();
+
+    // then:
+    EXPECT_TRUE(value.empty());
+    EXPECT_NE(held, any_cast<const Large>(&shared));
+    EXPECT_EQ(typeid(Large), shared.type());
+}
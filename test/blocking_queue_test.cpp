@@ -1,6 +1,8 @@
 #include "ccl/blocking_queue.h"
 #include <chrono>
+#include <iterator>
 #include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include "ccl/countdown_latch.h"
 #include "util.h"
@@ -205,3 +207,120 @@ TEST(BlockingQueue, Clear) {
     EXPECT_EQ(last, queue.Pop());
     EXPECT_TRUE(queue.Empty());
 }
+
+TEST(BlockingQueue, PushAllAndDrainTo) {
+    // setup:
+    const std::vector<int> pushed = {1, 2, 3, 4, 5};
+
+    // when:
+    BlockingQueue<int> queue;
+    queue.PushAll(pushed.begin(), pushed.end());
+
+    // and:
+    std::vector<int> drained;
+    size_t count1 = queue.DrainTo(std::back_inserter(drained), 3);
+    size_t count2 = queue.DrainTo(std::back_inserter(drained), 3);
+
+    // then:
+    EXPECT_EQ(3, count1);
+    EXPECT_EQ(2, count2);
+    EXPECT_EQ(pushed, drained);
+    EXPECT_TRUE(queue.Empty());
+}
+
+TEST(BlockingQueue, PushAll_Blocking) {
+    // setup:
+    const int capacity = 3;
+    const int count = 10;
+    std::vector<int> pushed;
+    for (int i = 0; i < count; i++) {
+        pushed.push_back(i);
+    }
+
+    // when: push more elements than the capacity
+    BlockingQueue<int> queue(capacity);
+    std::thread th([&]() {
+        queue.PushAll(pushed.begin(), pushed.end());
+    });
+    util::Delay();
+
+    // then:
+    EXPECT_EQ(capacity, queue.Size());
+
+    // when:
+    std::vector<int> drained;
+    while (drained.size() < pushed.size()) {
+        queue.DrainTo(std::back_inserter(drained), capacity);
+    }
+    th.join();
+
+    // then:
+    EXPECT_EQ(pushed, drained);
+}
+
+TEST(BlockingQueue, DrainTo_Blocking) {
+    // when:
+    BlockingQueue<int> queue;
+    std::thread th([&]() {
+        util::DoHeavyTask();
+        queue.Push(1);
+    });
+    std::vector<int> drained;
+    size_t count = queue.DrainTo(std::back_inserter(drained), 10);
+
+    // then:
+    EXPECT_EQ(1, count);
+    EXPECT_EQ(1, drained.at(0));
+
+    // cleanup:
+    th.join();
+}
+
+TEST(BlockingQueue, DrainTo_Timeout) {
+    // when:
+    BlockingQueue<int> queue;
+    std::vector<int> drained;
+    size_t count = queue.DrainTo(std::back_inserter(drained), 10, std::chrono::milliseconds(10));
+
+    // then:
+    EXPECT_EQ(0, count);
+    EXPECT_TRUE(drained.empty());
+}
+
+TEST(BlockingQueue, PushAll_MoveIterator) {
+    // setup:
+    std::vector<util::CopyCounter> pushed(2);
+
+    // when:
+    BlockingQueue<util::CopyCounter> queue;
+    queue.PushAll(std::make_move_iterator(pushed.begin()), std::make_move_iterator(pushed.end()));
+    std::vector<util::CopyCounter> drained;
+    drained.reserve(2);
+    queue.DrainTo(std::back_inserter(drained), 2);
+
+    // then:
+    ASSERT_EQ(2, drained.size());
+    EXPECT_EQ(0, drained[0].CopyConstructorCount());
+    EXPECT_EQ(0, drained[0].CopyAssignmentCount());
+}
+
+TEST(BlockingQueue, PushAndPop_SpinThenPark) {
+    // setup:
+    const int pushCount = 10000;
+    long sum = 0;
+
+    // when:
+    BlockingQueue<int, SpinThenParkWait<>> queue(16);
+    std::thread th([&]() {
+        for (int i = 1; i <= pushCount; i++) {
+            queue.Push(i);
+        }
+    });
+    for (int i = 0; i < pushCount; i++) {
+        sum += queue.Pop();
+    }
+    th.join();
+
+    // then:
+    EXPECT_EQ(static_cast<long>(pushCount) * (pushCount + 1) / 2, sum);
+}
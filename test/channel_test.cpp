@@ -1,5 +1,9 @@
 #include "ccl/channel.h"
+#include <atomic>
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include "util.h"
 
@@ -15,9 +19,9 @@ TEST(Channel, SendAndReceive_MoveSemantics) {
 
     // then:
     EXPECT_EQ(0, counter.CopyConstructorCount());
-    EXPECT_EQ(1, counter.CopyAssignmentCount());
+    EXPECT_EQ(0, counter.CopyAssignmentCount());
     EXPECT_EQ(1, counter.MoveConstructorCount());
-    EXPECT_EQ(0, counter.MoveAssignmentCount());
+    EXPECT_EQ(1, counter.MoveAssignmentCount());
 
     // cleanup:
     th.join();
@@ -34,7 +38,7 @@ TEST(Channel, SendAndReceiveOperator_MoveSemantics) {
 
     // then:
     EXPECT_EQ(0, counter.CopyConstructorCount());
-    EXPECT_EQ(1, counter.CopyAssignmentCount());
+    EXPECT_EQ(0, counter.CopyAssignmentCount());
     EXPECT_EQ(1, counter.MoveConstructorCount());
     EXPECT_EQ(1, counter.MoveAssignmentCount());
 
@@ -42,6 +46,21 @@ TEST(Channel, SendAndReceiveOperator_MoveSemantics) {
     th.join();
 }
 
+TEST(Channel, SendLvalue_CopiesOnce) {
+    // when:
+    Channel<util::CopyCounter> chan(1);
+    util::CopyCounter sent;
+    chan.Send(sent);
+    util::CopyCounter counter;
+    chan.Receive(counter);
+
+    // then:
+    EXPECT_EQ(1, counter.CopyConstructorCount());
+    EXPECT_EQ(0, counter.CopyAssignmentCount());
+    EXPECT_EQ(0, counter.MoveConstructorCount());
+    EXPECT_EQ(1, counter.MoveAssignmentCount());
+}
+
 TEST(Channel, SendAndReceive) {
     // setup:
     const int sendCount = 10;
@@ -64,3 +83,187 @@ TEST(Channel, SendAndReceive) {
     // cleanup:
     th.join();
 }
+
+TEST(Channel, Send_Unbuffered_WaitsForReceiver) {
+    // when:
+    Channel<int> chan;
+    std::atomic<bool> sent(false);
+    std::thread th([&]() {
+        chan.Send(1);
+        sent = true;
+    });
+    util::Delay();
+
+    // then:
+    EXPECT_FALSE(sent);
+
+    // when:
+    chan.Receive();
+    th.join();
+
+    // then:
+    EXPECT_TRUE(sent);
+}
+
+TEST(Channel, Send_Buffered) {
+    // setup:
+    const int capacity = 4;
+
+    // when:
+    Channel<int> chan(capacity);
+    for (int i = 0; i < capacity; i++) {
+        chan.Send(i);
+    }
+    std::atomic<bool> sent(false);
+    std::thread th([&]() {
+        chan.Send(capacity);
+        sent = true;
+    });
+    util::Delay();
+
+    // then: blocks only when the buffer is full
+    EXPECT_FALSE(sent);
+
+    // when:
+    std::vector<int> received(capacity + 1);
+    for (int& message : received) {
+        chan.Receive(message);
+    }
+    th.join();
+
+    // then:
+    EXPECT_TRUE(sent);
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4}), received);
+}
+
+TEST(Channel, Close) {
+    // when:
+    Channel<int> chan(2);
+    chan.Send(1);
+    chan.Close();
+
+    // then: the buffered message is still received
+    EXPECT_FALSE(chan.Send(2));
+    int message = 0;
+    EXPECT_TRUE(chan.Receive(message));
+    EXPECT_EQ(1, message);
+    EXPECT_FALSE(chan.Receive(message));
+    EXPECT_FALSE(chan.TryReceive(message));
+}
+
+TEST(Channel, Close_WakesUpReceiver) {
+    // when:
+    Channel<int> chan;
+    bool received = true;
+    std::thread th([&]() {
+        int message;
+        received = chan.Receive(message);
+    });
+    util::Delay();
+    chan.Close();
+    th.join();
+
+    // then:
+    EXPECT_FALSE(received);
+}
+
+TEST(Channel, SendMoveOnly) {
+    // when:
+    Channel<std::unique_ptr<int>> chan(1);
+    chan.Send(std::unique_ptr<int>(new int(1)));
+    std::unique_ptr<int> message;
+    chan.Receive(message);
+
+    // then:
+    ASSERT_NE(nullptr, message);
+    EXPECT_EQ(1, *message);
+}
+
+TEST(Channel, TryReceive) {
+    // when:
+    Channel<int> chan(1);
+    int message = 0;
+    bool before = chan.TryReceive(message);
+    chan.Send(1);
+    bool after = chan.TryReceive(message);
+
+    // then:
+    EXPECT_FALSE(before);
+    EXPECT_TRUE(after);
+    EXPECT_EQ(1, message);
+}
+
+TEST(Select, Wait) {
+    // setup:
+    const int sendCount = 100;
+
+    // when:
+    Channel<int> numbers;
+    Channel<std::string> names(4);
+    std::thread th1([&]() {
+        for (int i = 0; i < sendCount; i++) {
+            numbers.Send(i);
+        }
+        numbers.Close();
+    });
+    std::thread th2([&]() {
+        for (int i = 0; i < sendCount; i++) {
+            names.Send(std::to_string(i));
+        }
+        names.Close();
+    });
+    int numberSum = 0;
+    int nameSum = 0;
+    Select select;
+    select.Case(numbers, [&](int n) { numberSum += n; })
+          .Case(names, [&](std::string name) { nameSum += std::stoi(name); });
+    while (select.Wait()) {}
+    th1.join();
+    th2.join();
+
+    // then:
+    EXPECT_EQ(sendCount * (sendCount - 1) / 2, numberSum);
+    EXPECT_EQ(sendCount * (sendCount - 1) / 2, nameSum);
+}
+
+TEST(Select, TryWait) {
+    // when:
+    Channel<int> chan1(1);
+    Channel<int> chan2(1);
+    int received = 0;
+    Select select;
+    select.Case(chan1, [&](int n) { received = n; })
+          .Case(chan2, [&](int n) { received = n; });
+    bool before = select.TryWait();
+    chan2.Send(2);
+    bool after = select.TryWait();
+
+    // then:
+    EXPECT_FALSE(before);
+    EXPECT_TRUE(after);
+    EXPECT_EQ(2, received);
+}
+
+TEST(Channel, SendAndReceive_BusySpin) {
+    // setup:
+    const int sendCount = 1000;
+
+    // when:
+    Channel<int, BusySpinWait> chan;
+    std::thread th([&]() {
+        for (int i = 0; i < sendCount; i++) {
+            chan.Send(i);
+        }
+        chan.Close();
+    });
+    int expected = 0;
+    int received;
+    while (chan.Receive(received)) {
+        // then:
+        EXPECT_EQ(expected++, received);
+    }
+    th.join();
+
+    // then:
+    EXPECT_EQ(sendCount, expected);
+}
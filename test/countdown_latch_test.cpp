@@ -1,6 +1,7 @@
 #include "ccl/countdown_latch.h"
 #include <chrono>
 #include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include "util.h"
 
@@ -77,3 +78,65 @@ TEST(CountdownLatch, Await_NoTimeout) {
     EXPECT_EQ(0, latch.GetCount());
     EXPECT_EQ(std::cv_status::no_timeout, status);
 }
+
+TEST(CountdownLatch, Await_SpinThenPark) {
+    // setup:
+    const int count = 3;
+
+    // when:
+    BasicCountdownLatch<SpinThenParkWait<>> latch(count);
+    std::thread th([&]() {
+        for (int i = 0; i < count; i++) {
+            latch.CountDown();
+        }
+    });
+    latch.Await();
+
+    // then:
+    EXPECT_EQ(0, latch.GetCount());
+
+    // cleanup:
+    th.join();
+}
+
+TEST(CountdownLatch, CountDown_Many) {
+    // when:
+    CountdownLatch latch(5);
+    latch.CountDown(3);
+
+    // then:
+    EXPECT_EQ(2, latch.GetCount());
+
+    // when: saturates at 0
+    latch.CountDown(3);
+
+    // then:
+    EXPECT_EQ(0, latch.GetCount());
+    EXPECT_EQ(std::cv_status::no_timeout, latch.Await(std::chrono::milliseconds(0)));
+}
+
+TEST(CountdownLatch, CountDown_Concurrent) {
+    // setup:
+    const int nthreads = 8;
+    const int countPerThread = 10000;
+
+    // when:
+    CountdownLatch latch(nthreads * countPerThread);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < countPerThread; j++) {
+                latch.CountDown();
+            }
+        });
+    }
+    latch.Await();
+
+    // then:
+    EXPECT_EQ(0, latch.GetCount());
+
+    // cleanup:
+    for (auto& th : threads) {
+        th.join();
+    }
+}
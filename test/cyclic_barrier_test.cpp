@@ -0,0 +1,144 @@
+#include "ccl/cyclic_barrier.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace ccl;
+
+TEST(CyclicBarrier, Await) {
+    // setup:
+    const int nthreads = 4;
+    const int phases = 100;
+    std::atomic<int> arrived(0);
+    std::atomic<int> mismatches(0);
+
+    // when:
+    CyclicBarrier barrier(nthreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++) {
+        threads.emplace_back([&]() {
+            for (int phase = 0; phase < phases; phase++) {
+                arrived++;
+                barrier.Await();
+                // every thread has arrived at this phase, and none has left it yet
+                if (arrived.load() < nthreads * (phase + 1)) {
+                    mismatches++;
+                }
+                barrier.Await();
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    // then:
+    EXPECT_EQ(nthreads * phases, arrived.load());
+    EXPECT_EQ(0, mismatches.load());
+    EXPECT_EQ(uint64_t(2 * phases), barrier.GetGeneration());
+}
+
+TEST(CyclicBarrier, Await_ArrivalIndex) {
+    // setup:
+    const int nthreads = 3;
+    std::atomic<int> sum(0);
+
+    // when:
+    CyclicBarrier barrier(nthreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++) {
+        threads.emplace_back([&]() {
+            sum += barrier.Await();
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    // then: 2 + 1 + 0
+    EXPECT_EQ(3, sum.load());
+}
+
+TEST(CyclicBarrier, Await_Completion) {
+    // setup:
+    const int nthreads = 4;
+    const int phases = 50;
+    int completions = 0;
+    std::atomic<int> mismatches(0);
+
+    // when:
+    CyclicBarrier barrier(nthreads, [&]() { completions++; });
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++) {
+        threads.emplace_back([&]() {
+            for (int phase = 0; phase < phases; phase++) {
+                barrier.Await();
+                // the completion has run before anyone is released
+                if (completions < phase + 1) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    // then:
+    EXPECT_EQ(phases, completions);
+    EXPECT_EQ(0, mismatches.load());
+}
+
+TEST(CyclicBarrier, Await_ThrowingCompletion) {
+    // setup:
+    const int nthreads = 4;
+    const int phases = 10;
+    std::atomic<int> thrown(0);
+
+    // when: the completion throws in every phase
+    CyclicBarrier barrier(nthreads, []() { throw std::runtime_error("error"); });
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++) {
+        threads.emplace_back([&]() {
+            for (int phase = 0; phase < phases; phase++) {
+                try {
+                    barrier.Await();
+                } catch (const std::runtime_error&) {
+                    thrown++;
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    // then: the others were released, and the barrier was reused
+    EXPECT_EQ(phases, thrown.load());
+    EXPECT_EQ(uint64_t(phases), barrier.GetGeneration());
+}
+
+TEST(CyclicBarrier, Await_SpinThenPark) {
+    // setup:
+    const int nthreads = 2;
+    const int phases = 100;
+
+    // when:
+    BasicCyclicBarrier<SpinThenParkWait<>> barrier(nthreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++) {
+        threads.emplace_back([&]() {
+            for (int phase = 0; phase < phases; phase++) {
+                barrier.Await();
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    // then:
+    EXPECT_EQ(uint64_t(phases), barrier.GetGeneration());
+}
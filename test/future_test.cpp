@@ -0,0 +1,341 @@
+#include "ccl/future.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include "ccl/countdown_latch.h"
+#include "ccl/thread_pool.h"
+#include "util.h"
+
+using namespace ccl;
+
+TEST(Future, Get) {
+    // setup:
+    Promise<std::string> promise;
+    Future<std::string> future = promise.GetFuture();
+
+    // when:
+    std::thread producer([&]() {
+        util::Delay();
+        promise.SetValue("value");
+    });
+
+    // then:
+    EXPECT_EQ("value", future.Get());
+    EXPECT_FALSE(future.Valid());
+
+    // cleanup:
+    producer.join();
+}
+
+TEST(Future, Get_Exception) {
+    // setup:
+    Promise<int> promise;
+    Future<int> future = promise.GetFuture();
+
+    // when:
+    promise.SetException(std::make_exception_ptr(std::runtime_error("error")));
+
+    // then:
+    EXPECT_TRUE(future.IsReady());
+    EXPECT_THROW(future.Get(), std::runtime_error);
+}
+
+TEST(Future, Get_BrokenPromise) {
+    // setup:
+    Future<int> future;
+
+    // when:
+    {
+        Promise<int> promise;
+        future = promise.GetFuture();
+    }
+
+    // then:
+    EXPECT_THROW(future.Get(), std::future_error);
+}
+
+TEST(Future, WaitFor) {
+    // setup:
+    Promise<void> promise;
+    Future<void> future = promise.GetFuture();
+
+    // when:
+    bool before = future.WaitFor(std::chrono::milliseconds(10));
+    promise.SetValue();
+    bool after = future.WaitFor(std::chrono::milliseconds(10));
+
+    // then:
+    EXPECT_FALSE(before);
+    EXPECT_TRUE(after);
+}
+
+TEST(Promise, SetValue_Twice) {
+    // setup:
+    Promise<int> promise;
+    Future<int> future = promise.GetFuture();
+
+    // when:
+    promise.SetValue(1);
+
+    // then:
+    EXPECT_THROW(promise.SetValue(2), std::future_error);
+    EXPECT_THROW(promise.GetFuture(), std::future_error);
+    EXPECT_EQ(1, future.Get());
+}
+
+TEST(Promise, SetValue_BeforeGetFuture) {
+    // setup:
+    Promise<int> promise;
+
+    // when:
+    promise.SetValue(1);
+    Future<int> future = promise.GetFuture();
+
+    // then:
+    EXPECT_THROW(promise.SetValue(2), std::future_error);
+    EXPECT_TRUE(future.IsReady());
+    EXPECT_EQ(1, future.Get());
+}
+
+TEST(Promise, SetException_BeforeGetFuture) {
+    // setup:
+    Promise<int> promise;
+
+    // when:
+    promise.SetException(std::make_exception_ptr(std::runtime_error("error")));
+    Future<int> future = promise.GetFuture();
+
+    // then:
+    EXPECT_THROW(future.Get(), std::runtime_error);
+}
+
+TEST(Future, Then_Inline) {
+    // setup:
+    Promise<int> promise;
+    Future<int> future = promise.GetFuture();
+    std::thread::id continuationThread;
+
+    // when: chain continuations, one of which returns void
+    Future<std::string> result = future.Then([](int x) {
+        return x + 1;
+    })
+    .Then([&](int x) {
+        continuationThread = std::this_thread::get_id();
+        return std::to_string(x);
+    });
+    Future<void> done = result.Then([](std::string s) {
+        EXPECT_EQ("2", s);
+    });
+
+    // and: complete on this thread
+    promise.SetValue(1);
+
+    // then: the continuations ran inline
+    EXPECT_FALSE(future.Valid());
+    EXPECT_EQ(std::this_thread::get_id(), continuationThread);
+    EXPECT_TRUE(done.IsReady());
+    EXPECT_NO_THROW(done.Get());
+}
+
+TEST(Future, Then_Ready) {
+    // setup:
+    Promise<int> promise;
+    Future<int> future = promise.GetFuture();
+    promise.SetValue(1);
+
+    // when: attach a continuation to a ready future
+    Future<int> result = future.Then([](int x) {
+        return x * 10;
+    });
+
+    // then:
+    EXPECT_TRUE(result.IsReady());
+    EXPECT_EQ(10, result.Get());
+}
+
+TEST(Future, Then_Executor) {
+    // setup:
+    auto pool = std::make_shared<ThreadPool>(2);
+    Promise<int> promise;
+    Future<int> future = promise.GetFuture();
+    std::atomic<bool> onCaller(true);
+
+    // when:
+    Future<int> result = future.Then(pool, [&](int x) {
+        onCaller = false;
+        return x + 1;
+    });
+    promise.SetValue(1);
+
+    // then: the continuation ran on the pool
+    EXPECT_EQ(2, result.Get());
+    EXPECT_FALSE(onCaller);
+}
+
+TEST(Future, Then_Exception) {
+    // setup:
+    Promise<int> promise;
+    Future<int> future = promise.GetFuture();
+    int called = 0;
+
+    // when: the first continuation throws, so the second is skipped
+    Future<int> result = future.Then([&](int x) -> int {
+        called++;
+        throw std::runtime_error("error");
+    })
+    .Then([&](int x) {
+        called++;
+        return x;
+    });
+    promise.SetValue(1);
+
+    // then:
+    EXPECT_THROW(result.Get(), std::runtime_error);
+    EXPECT_EQ(1, called);
+}
+
+TEST(Future, Then_Unwrap) {
+    // setup:
+    auto pool = std::make_shared<ThreadPool>(2);
+    Promise<int> promise;
+    Future<int> future = promise.GetFuture();
+
+    // when: the continuation returns a future
+    Future<int> result = future.Then([&](int x) {
+        Promise<int> inner;
+        Future<int> innerFuture = inner.GetFuture();
+        std::shared_ptr<Promise<int>> shared = std::make_shared<Promise<int>>(std::move(inner));
+        pool->Dispatch([shared, x]() {
+            shared->SetValue(x * 2);
+        });
+        return innerFuture;
+    });
+    promise.SetValue(21);
+
+    // then:
+    EXPECT_EQ(42, result.Get());
+}
+
+TEST(Future, OnComplete) {
+    // setup:
+    Promise<int> promise;
+    Future<int> future = promise.GetFuture();
+    std::string message;
+
+    // when:
+    future.OnComplete([&](Future<int> ready) {
+        try {
+            ready.Get();
+        } catch (const std::runtime_error& e) {
+            message = e.what();
+        }
+    });
+    promise.SetException(std::make_exception_ptr(std::runtime_error("error")));
+
+    // then:
+    EXPECT_EQ("error", message);
+}
+
+TEST(Future, Then_Concurrent) {
+    // setup:
+    const int count = 1000;
+    std::vector<Promise<int>> promises(count);
+    std::atomic<int> sum(0);
+    CountdownLatch latch(count);
+    auto pool = std::make_shared<ThreadPool>(4); // joined before the promises go
+
+    // when: complete the promises while continuations are attached
+    std::vector<Future<void>> results;
+    for (int i = 0; i < count; i++) {
+        Future<int> future = promises[i].GetFuture();
+        pool->Dispatch([&promises, i]() {
+            promises[i].SetValue(i);
+        });
+        results.push_back(future.Then([&](int x) {
+            sum += x;
+            latch.CountDown();
+        }));
+    }
+
+    // then:
+    latch.Await();
+    EXPECT_EQ(count * (count - 1) / 2, sum.load());
+}
+
+TEST(Future, WhenAll) {
+    // setup:
+    std::vector<Promise<int>> promises(10);
+    auto pool = std::make_shared<ThreadPool>(4); // joined before the promises go
+    std::vector<Future<int>> futures;
+    for (auto& promise : promises) {
+        futures.push_back(promise.GetFuture());
+    }
+
+    // when:
+    Future<std::vector<int>> all = WhenAll(std::move(futures));
+    for (int i = 9; i >= 0; i--) {
+        pool->Dispatch([&promises, i]() {
+            promises[i].SetValue(i);
+        });
+    }
+
+    // then: the values are in the order of the futures
+    std::vector<int> values = all.Get();
+    ASSERT_EQ(10u, values.size());
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(i, values[i]);
+    }
+}
+
+TEST(Future, WhenAll_Exception) {
+    // setup:
+    Promise<int> first;
+    Promise<int> second;
+    std::vector<Future<int>> futures;
+    futures.push_back(first.GetFuture());
+    futures.push_back(second.GetFuture());
+
+    // when:
+    Future<std::vector<int>> all = WhenAll(std::move(futures));
+    second.SetException(std::make_exception_ptr(std::runtime_error("error")));
+
+    // then: fails without waiting for the other future
+    EXPECT_TRUE(all.IsReady());
+    EXPECT_THROW(all.Get(), std::runtime_error);
+
+    // cleanup:
+    first.SetValue(1);
+}
+
+TEST(Future, WhenAll_Empty) {
+    // when:
+    Future<std::vector<int>> all = WhenAll(std::vector<Future<int>>());
+
+    // then:
+    EXPECT_TRUE(all.Get().empty());
+}
+
+TEST(Future, WhenAny) {
+    // setup:
+    std::vector<Promise<std::string>> promises(3);
+    std::vector<Future<std::string>> futures;
+    for (auto& promise : promises) {
+        futures.push_back(promise.GetFuture());
+    }
+
+    // when:
+    Future<std::pair<size_t, std::string>> any = WhenAny(std::move(futures));
+    promises[1].SetValue("second");
+    promises[0].SetValue("first");
+
+    // then:
+    std::pair<size_t, std::string> first = any.Get();
+    EXPECT_EQ(1u, first.first);
+    EXPECT_EQ("second", first.second);
+}
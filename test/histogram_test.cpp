@@ -0,0 +1,64 @@
+#include "ccl/histogram.h"
+#include <gtest/gtest.h>
+
+using namespace ccl;
+
+TEST(Histogram, Record) {
+    // when:
+    Histogram histogram;
+    histogram.Record(0);
+    histogram.Record(1);
+    histogram.Record(5);
+    histogram.Record(7);
+    histogram.Record(8);
+
+    // then:
+    EXPECT_EQ(5u, histogram.Count());
+    EXPECT_EQ(21u, histogram.Sum());
+    EXPECT_EQ(1u, histogram.Bucket(0)); // 0
+    EXPECT_EQ(1u, histogram.Bucket(1)); // [1, 2)
+    EXPECT_EQ(2u, histogram.Bucket(3)); // [4, 8)
+    EXPECT_EQ(1u, histogram.Bucket(4)); // [8, 16)
+}
+
+TEST(Histogram, Percentile) {
+    // when:
+    Histogram histogram;
+    for (int i = 0; i < 99; i++) {
+        histogram.Record(100); // [64, 128)
+    }
+    histogram.Record(5000); // [4096, 8192)
+
+    // then:
+    EXPECT_EQ(127u, histogram.Percentile(0.5));
+    EXPECT_EQ(127u, histogram.Percentile(0.98));
+    EXPECT_EQ(8191u, histogram.Percentile(0.99));
+    EXPECT_EQ(8191u, histogram.Percentile(1.0));
+    EXPECT_EQ(0u, Histogram().Percentile(0.5));
+}
+
+TEST(Histogram, BucketOf) {
+    // then:
+    EXPECT_EQ(0u, Histogram::BucketOf(0));
+    EXPECT_EQ(1u, Histogram::BucketOf(1));
+    EXPECT_EQ(2u, Histogram::BucketOf(2));
+    EXPECT_EQ(2u, Histogram::BucketOf(3));
+    EXPECT_EQ(64u, Histogram::BucketOf(UINT64_MAX));
+    EXPECT_EQ(UINT64_MAX, Histogram::UpperBound(64));
+}
+
+TEST(AtomicHistogram, AddTo) {
+    // when:
+    AtomicHistogram atomicHistogram;
+    atomicHistogram.Record(3);
+    atomicHistogram.Record(300);
+    Histogram histogram;
+    histogram.Record(3);
+    atomicHistogram.AddTo(&histogram);
+
+    // then:
+    EXPECT_EQ(3u, histogram.Count());
+    EXPECT_EQ(306u, histogram.Sum());
+    EXPECT_EQ(2u, histogram.Bucket(2));
+    EXPECT_EQ(1u, histogram.Bucket(9));
+}
@@ -0,0 +1,133 @@
+#include "ccl/mailbox.h"
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "util.h"
+
+using namespace ccl;
+
+namespace {
+
+std::atomic<size_t> allocations(0);
+
+} // namespace
+
+// Counts the allocations of this test binary. Not inlined, so that GCC does
+// not mistake free for a mismatched deallocation.
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size != 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+TEST(Mailbox, PushAndPop_FIFO) {
+    // when:
+    Mailbox<int> mailbox;
+    for (int i = 0; i < 3; i++) {
+        mailbox.Push(i);
+    }
+
+    // then:
+    int popped;
+    for (int i = 0; i < 3; i++) {
+        EXPECT_TRUE(mailbox.Pop(&popped));
+        EXPECT_EQ(i, popped);
+    }
+    EXPECT_FALSE(mailbox.Pop(&popped));
+    EXPECT_TRUE(mailbox.Empty());
+}
+
+TEST(Mailbox, PushRvalueAndPop_MoveSemantics) {
+    // when:
+    Mailbox<util::CopyCounter> mailbox;
+    mailbox.Push(util::CopyCounter{});
+    util::CopyCounter counter;
+    mailbox.Pop(&counter);
+
+    // then:
+    EXPECT_EQ(0, counter.CopyConstructorCount());
+    EXPECT_EQ(0, counter.CopyAssignmentCount());
+    EXPECT_EQ(1, counter.MoveConstructorCount());
+    EXPECT_EQ(1, counter.MoveAssignmentCount());
+}
+
+TEST(Mailbox, PushAndPop_ReusesNodes) {
+    // setup:
+    Mailbox<int> mailbox;
+    int popped;
+    mailbox.Push(0);
+    mailbox.Pop(&popped);
+
+    // when: the popped nodes are pushed again
+    size_t before = allocations.load();
+    for (int i = 0; i < 1000; i++) {
+        mailbox.Push(i);
+        mailbox.Push(i);
+        mailbox.Pop(&popped);
+        mailbox.Pop(&popped);
+    }
+
+    // then: only the second node of the first pair was allocated
+    EXPECT_EQ(1u, allocations.load() - before);
+}
+
+TEST(Mailbox, Destructor_DestroysRemainingElements) {
+    // setup:
+    auto element = std::make_shared<int>(0);
+
+    // when:
+    {
+        Mailbox<std::shared_ptr<int>> mailbox;
+        mailbox.Push(element);
+        mailbox.Push(element);
+        EXPECT_EQ(3, element.use_count());
+    }
+
+    // then:
+    EXPECT_EQ(1, element.use_count());
+}
+
+TEST(Mailbox, PushAndPop_MultiProducerSingleConsumer) {
+    // setup:
+    const int nproducers = 4;
+    const int pushCount = 10000;
+    long sum = 0;
+
+    // when:
+    Mailbox<int> mailbox;
+    std::vector<std::thread> producers;
+    for (int i = 0; i < nproducers; i++) {
+        producers.emplace_back([&]() {
+            for (int j = 1; j <= pushCount; j++) {
+                mailbox.Push(j);
+            }
+        });
+    }
+    for (int popCount = 0; popCount < nproducers * pushCount;) {
+        int popped;
+        if (mailbox.Pop(&popped)) {
+            sum += popped;
+            popCount++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& th : producers) {
+        th.join();
+    }
+
+    // then:
+    EXPECT_EQ(static_cast<long>(nproducers) * pushCount * (pushCount + 1) / 2, sum);
+    EXPECT_TRUE(mailbox.Empty());
+}
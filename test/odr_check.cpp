@@ -1,6 +1,20 @@
 #include "ccl/actor.h"
+#include "ccl/actor_core.h"
+#include "ccl/any.h"
 #include "ccl/blocking_queue.h"
+#include "ccl/channel.h"
 #include "ccl/countdown_latch.h"
+#include "ccl/cyclic_barrier.h"
+#include "ccl/future.h"
+#include "ccl/histogram.h"
+#include "ccl/mailbox.h"
+#include "ccl/phaser.h"
 #include "ccl/pubsub.h"
+#include "ccl/ring_buffer_queue.h"
 #include "ccl/scheduler.h"
+#include "ccl/task.h"
 #include "ccl/thread_pool.h"
+#include "ccl/trace.h"
+#include "ccl/typed_actor.h"
+#include "ccl/wait_strategy.h"
+#include "ccl/work_stealing_deque.h"
@@ -0,0 +1,166 @@
+#include "ccl/phaser.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace ccl;
+
+TEST(Phaser, ArriveAndAwaitAdvance) {
+    // setup:
+    const int nthreads = 4;
+    const int phases = 100;
+    std::atomic<int> arrived(0);
+    std::atomic<int> mismatches(0);
+
+    // when:
+    Phaser phaser(nthreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++) {
+        threads.emplace_back([&]() {
+            for (int phase = 0; phase < phases; phase++) {
+                arrived++;
+                phaser.ArriveAndAwaitAdvance();
+                if (arrived.load() < nthreads * (phase + 1)) {
+                    mismatches++;
+                }
+                phaser.ArriveAndAwaitAdvance();
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    // then:
+    EXPECT_EQ(0, mismatches.load());
+    EXPECT_EQ(uint32_t(2 * phases), phaser.GetPhase());
+}
+
+TEST(Phaser, Register) {
+    // when:
+    Phaser phaser;
+    uint32_t phase = phaser.Register(2);
+
+    // then:
+    EXPECT_EQ(0u, phase);
+    EXPECT_EQ(2u, phaser.GetRegisteredParties());
+    EXPECT_EQ(2u, phaser.GetUnarrivedParties());
+
+    // when:
+    phaser.Arrive();
+
+    // then:
+    EXPECT_EQ(0u, phaser.GetPhase());
+    EXPECT_EQ(1u, phaser.GetUnarrivedParties());
+
+    // when: a party joins the current phase
+    phaser.Register();
+    phaser.Arrive();
+
+    // then:
+    EXPECT_EQ(0u, phaser.GetPhase());
+
+    // when:
+    phaser.Arrive();
+
+    // then:
+    EXPECT_EQ(1u, phaser.GetPhase());
+    EXPECT_EQ(3u, phaser.GetRegisteredParties());
+    EXPECT_EQ(3u, phaser.GetUnarrivedParties());
+}
+
+TEST(Phaser, Register_TooManyParties) {
+    // setup:
+    Phaser phaser(65534);
+
+    // when:
+    phaser.Register();
+
+    // then: the state is left as it was
+    EXPECT_THROW(phaser.Register(), std::length_error);
+    EXPECT_THROW(phaser.Register(1u << 16), std::length_error);
+    EXPECT_EQ(65535u, phaser.GetRegisteredParties());
+    EXPECT_EQ(65535u, phaser.GetUnarrivedParties());
+    EXPECT_THROW(Phaser(65536), std::length_error);
+}
+
+TEST(Phaser, ArriveAndDeregister) {
+    // when:
+    Phaser phaser(3);
+    phaser.ArriveAndDeregister();
+    phaser.Arrive();
+
+    // then:
+    EXPECT_EQ(0u, phaser.GetPhase());
+
+    // when:
+    phaser.Arrive();
+
+    // then: the next phase waits for the remaining two parties only
+    EXPECT_EQ(1u, phaser.GetPhase());
+    EXPECT_EQ(2u, phaser.GetRegisteredParties());
+    EXPECT_EQ(2u, phaser.GetUnarrivedParties());
+
+    // when: arrivals beyond the registered parties are ignored
+    Phaser empty;
+    empty.Arrive();
+
+    // then:
+    EXPECT_EQ(0u, empty.GetPhase());
+}
+
+TEST(Phaser, AwaitAdvance_DynamicParties) {
+    // setup:
+    const int nthreads = 4;
+    const int phases = 20;
+
+    // when: the workers join and leave while the coordinator drives the phases
+    Phaser phaser(1);
+    std::vector<uint32_t> lastPhases(nthreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++) {
+        phaser.Register();
+        threads.emplace_back([&, i]() {
+            for (int phase = 0; phase < phases + i; phase++) {
+                lastPhases[i] = phaser.ArriveAndAwaitAdvance();
+            }
+            phaser.ArriveAndDeregister();
+        });
+    }
+    while (phaser.GetRegisteredParties() > 1) {
+        phaser.ArriveAndAwaitAdvance();
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    // then:
+    for (int i = 0; i < nthreads; i++) {
+        EXPECT_EQ(uint32_t(phases + i), lastPhases[i]);
+    }
+    EXPECT_EQ(1u, phaser.GetRegisteredParties());
+}
+
+TEST(Phaser, AwaitAdvance_SpinThenPark) {
+    // setup:
+    const int phases = 100;
+
+    // when:
+    BasicPhaser<SpinThenParkWait<>> phaser(2);
+    std::thread th([&]() {
+        for (int phase = 0; phase < phases; phase++) {
+            phaser.ArriveAndAwaitAdvance();
+        }
+    });
+    for (int phase = 0; phase < phases; phase++) {
+        phaser.ArriveAndAwaitAdvance();
+    }
+
+    // then:
+    EXPECT_EQ(uint32_t(phases), phaser.GetPhase());
+
+    // cleanup:
+    th.join();
+}
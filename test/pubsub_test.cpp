@@ -1,4 +1,12 @@
 #include "ccl/pubsub.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include "ccl/countdown_latch.h"
 
@@ -187,3 +195,182 @@ TEST(PubSub, Multicast_PartialMatch) {
     EXPECT_EQ("foo", recvMsg2);
     EXPECT_TRUE(ok);
 }
+
+TEST(PubSub, Broadcast_SharesPayload) {
+    // setup:
+    const int nactors = 10;
+    std::vector<const std::vector<char>*> received(nactors);
+    CountdownLatch latch(nactors);
+
+    // when:
+    PubSub broker;
+    std::vector<std::shared_ptr<Actor>> actors;
+    for (int i = 0; i < nactors; i++) {
+        auto actor = std::make_shared<Actor>([&, i](any& msg) {
+            received[i] = any_cast<const std::vector<char>>(&msg);
+            latch.CountDown();
+            return 0;
+        });
+        broker.Subscribe("/topic/" + std::to_string(i), actor);
+        actors.push_back(actor);
+    }
+    broker.Broadcast(std::vector<char>(1024));
+    latch.Await();
+
+    // then: every subscriber reads the same copy
+    for (int i = 1; i < nactors; i++) {
+        EXPECT_EQ(received[0], received[i]);
+    }
+}
+
+TEST(PubSub, Multicast_Wildcards) {
+    // setup:
+    std::mutex mutex;
+    std::vector<std::string> received;
+    auto pool = std::make_shared<ThreadPool>(1);
+    PubSub broker;
+    for (auto& topic : {"/a/x/1", "/a/y/1", "/a/y/2", "/a/x/1/z", "/b/x/1", "/a.x/1"}) {
+        std::string name = topic;
+        broker.Subscribe(topic, std::make_shared<Actor>(pool, [&, name](any& msg) {
+            std::lock_guard<std::mutex> lock(mutex);
+            received.push_back(name);
+            return 0;
+        }));
+    }
+
+    // when:
+    auto multicast = [&](const std::string& pattern) {
+        received.clear();
+        broker.Multicast(pattern, 0);
+        std::promise<void> done; // queued behind the actors
+        pool->Dispatch([&]() { done.set_value(); });
+        done.get_future().get();
+        std::lock_guard<std::mutex> lock(mutex);
+        std::sort(received.begin(), received.end());
+        return received;
+    };
+
+    // then:
+    EXPECT_EQ(std::vector<std::string>({"/a/x/1", "/a/y/1"}), multicast("/a/+/1"));
+    EXPECT_EQ(std::vector<std::string>({"/a/x/1", "/b/x/1"}), multicast("/+/x/1"));
+    EXPECT_EQ(std::vector<std::string>({"/a/x/1", "/a/x/1/z"}), multicast("/a/x/#"));
+    EXPECT_EQ(std::vector<std::string>({"/a/x/1/z"}), multicast("/a/x/1/#"));
+    EXPECT_EQ(std::vector<std::string>({"/a.x/1"}), multicast("/a.x/+"));
+    EXPECT_EQ(std::vector<std::string>(), multicast("/a/+"));
+    EXPECT_EQ(6, multicast("#").size());
+}
+
+TEST(PubSub, Multicast_SeesNewTopics) {
+    // setup:
+    CountdownLatch latch(2);
+    auto actor = std::make_shared<Actor>([&](any& msg) {
+        latch.CountDown();
+        return 0;
+    });
+
+    // when: the same pattern is used before and after subscribing
+    PubSub broker;
+    broker.Subscribe("/a/1", actor);
+    broker.Multicast("/a/+", 0);
+    broker.Subscribe("/a/2", actor);
+    broker.Unsubscribe("/a/1", actor);
+    broker.Multicast("/a/+", 0);
+
+    // then:
+    latch.Await();
+    EXPECT_EQ(std::vector<std::string>({"/a/2"}), broker.GetTopics());
+}
+
+TEST(PubSub, Unsubscribe_RemovesEmptyTopic) {
+    // setup:
+    auto actor = std::make_shared<Actor>([](any& msg) {
+        return 0;
+    });
+
+    // when:
+    PubSub broker;
+    broker.Subscribe("/a/b", actor);
+    broker.Subscribe("/a/b/c", actor);
+    broker.Unsubscribe("/a/b/c", actor);
+    broker.Publish("/x", 0);
+    broker.GetSubscribers("/y");
+
+    // then:
+    EXPECT_EQ(std::vector<std::string>({"/a/b"}), broker.GetTopics());
+}
+
+TEST(PubSub, GetTopics) {
+    // setup:
+    auto actor = std::make_shared<Actor>([](any& msg) {
+        return 0;
+    });
+
+    // when:
+    PubSub broker;
+    for (auto& topic : {"/a", "a/b", "a", "", "/", "//x"}) {
+        broker.Subscribe(topic, actor);
+    }
+
+    // then:
+    EXPECT_EQ(std::vector<std::string>({"", "/", "//x", "/a", "a", "a/b"}), broker.GetTopics());
+}
+
+TEST(PubSub, Subscribe_ManyTopics) {
+    // setup:
+    const int ntopics = 1000;
+    auto actor = std::make_shared<Actor>([](any& msg) {
+        return 0;
+    });
+
+    // when: enough children to split the child tables
+    PubSub broker;
+    for (int i = 0; i < ntopics; i++) {
+        broker.Subscribe("/device/" + std::to_string(i), actor);
+    }
+    for (int i = 0; i < ntopics; i += 2) {
+        broker.Unsubscribe("/device/" + std::to_string(i), actor);
+    }
+
+    // then:
+    EXPECT_EQ(ntopics / 2, broker.GetTopics().size());
+    for (int i = 0; i < ntopics; i++) {
+        EXPECT_EQ(i % 2, broker.GetSubscribers("/device/" + std::to_string(i)).size());
+    }
+}
+
+TEST(PubSub, Publish_ConcurrentWithSubscribe) {
+    // setup:
+    const int npublishers = 4;
+    const int publishCount = 1000;
+    std::atomic<int> received(0);
+    auto pool = std::make_shared<ThreadPool>(2);
+    auto actor = std::make_shared<Actor>(pool, [&](any& msg) {
+        received++;
+        return 0;
+    });
+
+    // when: publishers run while the subscriptions change
+    PubSub broker;
+    broker.Subscribe("/topic", actor);
+    std::vector<std::thread> publishers;
+    for (int i = 0; i < npublishers; i++) {
+        publishers.emplace_back([&]() {
+            for (int j = 0; j < publishCount; j++) {
+                broker.Publish("/topic", j);
+            }
+        });
+    }
+    for (int i = 0; i < publishCount; i++) {
+        broker.Subscribe("/other/" + std::to_string(i), actor);
+        broker.Unsubscribe("/other/" + std::to_string(i), actor);
+    }
+    for (auto& th : publishers) {
+        th.join();
+    }
+    pool->Shutdown();
+    pool->AwaitTermination();
+
+    // then:
+    EXPECT_EQ(npublishers * publishCount, received);
+    EXPECT_EQ(std::vector<std::string>({"/topic"}), broker.GetTopics());
+}
@@ -0,0 +1,254 @@
+#include "ccl/ring_buffer_queue.h"
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "ccl/countdown_latch.h"
+#include "util.h"
+
+using namespace ccl;
+
+TEST(RingBufferQueue, PushLvalueAndPop_MoveSemantics) {
+    // when:
+    RingBufferQueue<util::CopyCounter> queue;
+    util::CopyCounter pushed;
+    queue.Push(pushed);
+    auto counter = queue.Pop();
+
+    // then:
+    EXPECT_EQ(1, counter.CopyConstructorCount());
+    EXPECT_EQ(0, counter.CopyAssignmentCount());
+    EXPECT_EQ(0, counter.MoveConstructorCount());
+    EXPECT_EQ(1, counter.MoveAssignmentCount());
+}
+
+TEST(RingBufferQueue, PushRvalueAndPop_MoveSemantics) {
+    // when:
+    RingBufferQueue<util::CopyCounter> queue;
+    queue.Push(util::CopyCounter{});
+    auto counter = queue.Pop();
+
+    // then:
+    EXPECT_EQ(0, counter.CopyConstructorCount());
+    EXPECT_EQ(0, counter.CopyAssignmentCount());
+    EXPECT_EQ(1, counter.MoveConstructorCount());
+    EXPECT_EQ(1, counter.MoveAssignmentCount());
+}
+
+TEST(RingBufferQueue, Capacity_PowerOfTwo) {
+    // when:
+    RingBufferQueue<int> queue1(1);
+    RingBufferQueue<int> queue2(5);
+    RingBufferQueue<int> queue3(SIZE_MAX);
+
+    // then:
+    EXPECT_EQ(2, queue1.Capacity());
+    EXPECT_EQ(8, queue2.Capacity());
+    EXPECT_EQ(1024, queue3.Capacity());
+}
+
+TEST(RingBufferQueue, Push_Blocking) {
+    // setup:
+    const int capacity = 4;
+    CountdownLatch latch(capacity);
+
+    // when:
+    RingBufferQueue<int> queue(capacity);
+    for (int i = 0; i < capacity + 1; i++) {
+        std::thread th([&]() {
+            queue.Push(i);
+            latch.CountDown();
+        });
+        th.detach();
+    }
+    latch.Await();
+
+    // then:
+    util::Delay();
+    EXPECT_EQ(capacity, queue.Size());
+    queue.Pop();
+    queue.Pop();
+    util::Delay();
+    EXPECT_EQ(capacity - 1, queue.Size());
+}
+
+TEST(RingBufferQueue, Pop_Blocking) {
+    // setup:
+    const std::string pushed = "element";
+
+    // when:
+    RingBufferQueue<std::string> queue;
+    std::thread th([&]() {
+        util::DoHeavyTask();
+        queue.Push(pushed);
+    });
+    std::string popped = queue.Pop();
+
+    // then:
+    EXPECT_EQ(pushed, popped);
+
+    // clenup:
+    th.join();
+}
+
+TEST(RingBufferQueue, Push_Timeout) {
+    // when:
+    RingBufferQueue<int> queue(2);
+    queue.Push(1);
+    queue.Push(2);
+    std::cv_status status = queue.Push(3, std::chrono::milliseconds(10));
+
+    // then:
+    EXPECT_EQ(std::cv_status::timeout, status);
+    EXPECT_EQ(2, queue.Size());
+}
+
+TEST(RingBufferQueue, Pop_Timeout) {
+    // when:
+    RingBufferQueue<int> queue;
+    int unused;
+    std::cv_status status = queue.Pop(std::chrono::milliseconds(10), &unused);
+
+    // then:
+    EXPECT_EQ(std::cv_status::timeout, status);
+}
+
+TEST(RingBufferQueue, Pop_NoTimeout) {
+    // setup:
+    int pushed = 1;
+
+    // when:
+    RingBufferQueue<int> queue;
+    queue.Push(pushed);
+
+    // and:
+    int popped;
+    std::cv_status status = queue.Pop(std::chrono::seconds(10), &popped);
+
+    // then:
+    EXPECT_EQ(std::cv_status::no_timeout, status);
+    EXPECT_EQ(pushed, popped);
+}
+
+TEST(RingBufferQueue, PushAndPop_MultiProducerMultiConsumer) {
+    // setup:
+    const int nproducers = 4;
+    const int nconsumers = 4;
+    const int pushCount = 10000;
+    std::atomic<long> sum(0);
+
+    // when:
+    RingBufferQueue<int> queue(16);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nproducers; i++) {
+        threads.emplace_back([&]() {
+            for (int j = 1; j <= pushCount; j++) {
+                queue.Push(j);
+            }
+        });
+    }
+    for (int i = 0; i < nconsumers; i++) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < pushCount * nproducers / nconsumers; j++) {
+                sum += queue.Pop();
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    // then:
+    EXPECT_EQ(static_cast<long>(nproducers) * pushCount * (pushCount + 1) / 2, sum);
+    EXPECT_TRUE(queue.Empty());
+}
+
+TEST(RingBufferQueue, Clear) {
+    // setup:
+    const int count = 128;
+    const int last = -1;
+
+    // when: push until capcity is full
+    RingBufferQueue<int> queue(count);
+    for (int i = 0; i < count; i++) {
+        queue.Push(i);
+    }
+
+    // and: wait until popped
+    std::thread th([&]() {
+        queue.Push(last);
+    });
+
+    // and: wait until pushed the last element and clear
+    util::Delay();
+    queue.Clear();
+    th.join();
+
+    // then:
+    EXPECT_EQ(last, queue.Pop());
+    EXPECT_TRUE(queue.Empty());
+}
+
+TEST(RingBufferQueue, PushAllAndDrainTo) {
+    // setup:
+    const std::vector<int> pushed = {1, 2, 3, 4, 5};
+
+    // when:
+    RingBufferQueue<int> queue;
+    queue.PushAll(pushed.begin(), pushed.end());
+
+    // and:
+    std::vector<int> drained;
+    size_t count1 = queue.DrainTo(std::back_inserter(drained), 3);
+    size_t count2 = queue.DrainTo(std::back_inserter(drained), 3);
+
+    // then:
+    EXPECT_EQ(3, count1);
+    EXPECT_EQ(2, count2);
+    EXPECT_EQ(pushed, drained);
+    EXPECT_TRUE(queue.Empty());
+}
+
+TEST(RingBufferQueue, PushAll_Blocking) {
+    // setup:
+    const int capacity = 4;
+    const int count = 10;
+    std::vector<int> pushed;
+    for (int i = 0; i < count; i++) {
+        pushed.push_back(i);
+    }
+
+    // when: push more elements than the capacity
+    RingBufferQueue<int> queue(capacity);
+    std::thread th([&]() {
+        queue.PushAll(pushed.begin(), pushed.end());
+    });
+    util::Delay();
+
+    // then:
+    EXPECT_EQ(capacity, queue.Size());
+
+    // when:
+    std::vector<int> drained;
+    while (drained.size() < pushed.size()) {
+        queue.DrainTo(std::back_inserter(drained), capacity);
+    }
+    th.join();
+
+    // then:
+    EXPECT_EQ(pushed, drained);
+}
+
+TEST(RingBufferQueue, DrainTo_Timeout) {
+    // when:
+    RingBufferQueue<int> queue;
+    std::vector<int> drained;
+    size_t count = queue.DrainTo(std::back_inserter(drained), 10, std::chrono::milliseconds(10));
+
+    // then:
+    EXPECT_EQ(0, count);
+    EXPECT_TRUE(drained.empty());
+}
@@ -1,9 +1,15 @@
 #include "ccl/scheduler.h"
 #include <ctime>
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 #include "ccl/countdown_latch.h"
+#include "ccl/thread_pool.h"
+#include "util.h"
 
 using namespace ccl;
 using namespace std::chrono;
@@ -105,3 +111,409 @@ TEST(Scheduler, Cancel) {
     // then:
     EXPECT_GT(repeatCount, count);
 }
+
+TEST(Scheduler, Cancel_Handle) {
+    for (auto backend : {SchedulerBackend::Heap, SchedulerBackend::TimingWheel}) {
+        // setup:
+        const auto startTime = system_clock::now() + milliseconds(10);
+        std::atomic<int> cancelledCount(0);
+        CountdownLatch latch(1);
+
+        // when:
+        Scheduler scheduler(backend);
+        TimerHandle cancelled = scheduler.Schedule(startTime, [&]() {
+            cancelledCount++;
+        });
+        TimerHandle fired = scheduler.Schedule(startTime + milliseconds(10), [&]() {
+            latch.CountDown();
+        });
+        bool result = cancelled.Cancel();
+        latch.Await();
+
+        // then:
+        EXPECT_TRUE(result);
+        EXPECT_FALSE(cancelled.Cancel());
+        EXPECT_FALSE(fired.Cancel());
+        EXPECT_EQ(0, cancelledCount);
+    }
+}
+
+TEST(Scheduler, Cancel_PeriodicHandle) {
+    for (auto backend : {SchedulerBackend::Heap, SchedulerBackend::TimingWheel}) {
+        // setup:
+        const int repeatCount = -1; // endless
+        const int stopCount = 3;
+        const auto startTime = steady_clock::now();
+        std::atomic<int> count(0);
+        CountdownLatch latch(stopCount);
+
+        // when: cancel while the task catches up on the runs that a slow
+        // task made it miss
+        Scheduler scheduler(backend);
+        scheduler.Schedule(startTime, []() {
+            util::DoHeavyTask();
+        });
+        TimerHandle handle = scheduler.Schedule(startTime + milliseconds(1), milliseconds(1), repeatCount, [&]() {
+            count++;
+            latch.CountDown();
+            std::this_thread::sleep_for(microseconds(100));
+        });
+        latch.Await();
+        bool result = handle.Cancel();
+        int countAtCancel = count;
+        std::this_thread::sleep_for(milliseconds(30));
+
+        // then: at most the execution in progress completes
+        EXPECT_TRUE(result);
+        EXPECT_GE(countAtCancel + 1, count);
+    }
+}
+
+TEST(Scheduler, Cancel_LateTask) {
+    for (auto backend : {SchedulerBackend::Heap, SchedulerBackend::TimingWheel}) {
+        // setup:
+        const int cancelCount = 5;
+        const auto startTime = steady_clock::now();
+        int count = 0;
+        bool result = false;
+        TimerHandle handle;
+        CountdownLatch latch(1);
+
+        // when: a slow task makes the periodic one late by about 50 periods,
+        // and it cancels itself in the middle of the runs it catches up on
+        Scheduler scheduler(backend);
+        scheduler.Schedule(startTime, []() {
+            util::DoHeavyTask();
+        });
+        handle = scheduler.Schedule(startTime + milliseconds(1), milliseconds(1), -1, [&]() {
+            if (++count == cancelCount) {
+                result = handle.Cancel();
+            }
+        });
+        scheduler.Schedule(startTime + milliseconds(60), [&]() {
+            latch.CountDown();
+        });
+        latch.Await();
+
+        // then:
+        EXPECT_TRUE(result);
+        EXPECT_EQ(cancelCount, count);
+    }
+}
+
+TEST(Scheduler, Destroy_LateTask) {
+    // setup:
+    const auto startTime = steady_clock::now();
+    std::atomic<int> count(0);
+    CountdownLatch latch(1);
+    int countAtStop;
+
+    // when: destroy the scheduler while a late periodic task catches up
+    {
+        Scheduler scheduler;
+        scheduler.Schedule(startTime, []() {
+            util::DoHeavyTask();
+        });
+        scheduler.Schedule(startTime + milliseconds(1), milliseconds(1), -1, [&]() {
+            if (++count == 3) {
+                latch.CountDown();
+            }
+            std::this_thread::sleep_for(microseconds(100));
+        });
+        latch.Await();
+    }
+    countAtStop = count;
+
+    // then: at most the run in progress completed
+    EXPECT_GT(10, countAtStop);
+}
+
+TEST(Scheduler, Schedule_SteadyClock) {
+    // setup:
+    const auto after = microseconds(500);
+    const auto baseTime = steady_clock::now();
+    steady_clock::time_point firedTime;
+    CountdownLatch latch(1);
+
+    // when:
+    Scheduler scheduler;
+    scheduler.SetSpinThreshold(milliseconds(1));
+    scheduler.Schedule(baseTime + after, [&]() {
+        firedTime = steady_clock::now();
+        latch.CountDown();
+    });
+    latch.Await();
+
+    // then: never early
+    EXPECT_LE(after, firedTime - baseTime);
+}
+
+TEST(Scheduler, SchedulePeriodically_SubMillisecond) {
+    // setup:
+    const int repeatCount = 9;
+    const auto period = microseconds(200);
+    const auto firstTime = steady_clock::now();
+    std::vector<steady_clock::time_point> firedTimes;
+    CountdownLatch latch(repeatCount + 1);
+
+    // when:
+    Scheduler scheduler;
+    scheduler.SetSpinThreshold(milliseconds(1));
+    scheduler.Schedule(firstTime, period, repeatCount, [&]() {
+        firedTimes.push_back(steady_clock::now());
+        latch.CountDown();
+    });
+    latch.Await();
+
+    // then:
+    ASSERT_EQ(repeatCount + 1, firedTimes.size());
+    for (int i = 0; i < repeatCount + 1; i++) {
+        EXPECT_LE(period * i, firedTimes[i] - firstTime);
+    }
+}
+
+TEST(Scheduler, Schedule_OnThreadPool) {
+    // setup:
+    const auto baseTime = steady_clock::now();
+    const auto after = milliseconds(20);
+    const auto slowTaskDuration = milliseconds(200);
+    steady_clock::time_point firedTime;
+    CountdownLatch latch(1);
+
+    // when: a slow task runs before another task is due
+    auto pool = std::make_shared<ThreadPool>(2);
+    Scheduler scheduler(pool);
+    scheduler.Schedule(baseTime, [&]() {
+        std::this_thread::sleep_for(slowTaskDuration);
+    });
+    scheduler.Schedule(baseTime + after, [&]() {
+        firedTime = steady_clock::now();
+        latch.CountDown();
+    });
+    latch.Await();
+
+    // then: the later task is not delayed by the slow one
+    EXPECT_LE(after, firedTime - baseTime);
+    EXPECT_GT(slowTaskDuration, firedTime - baseTime);
+}
+
+TEST(Scheduler, Schedule_SpinThenPark) {
+    // setup:
+    const auto after = milliseconds(10);
+    const auto baseTime = steady_clock::now();
+    steady_clock::time_point firedTime;
+    CountdownLatch latch(1);
+
+    // when:
+    BasicScheduler<SpinThenParkWait<>> scheduler;
+    scheduler.Schedule(baseTime + after, [&]() {
+        firedTime = steady_clock::now();
+        latch.CountDown();
+    });
+    latch.Await();
+
+    // then:
+    EXPECT_LE(after, firedTime - baseTime);
+}
+
+TEST(Scheduler, Schedule_TimingWheel) {
+    // setup:
+    const int after = 30;
+    const auto baseTime = system_clock::now();
+    CountdownLatch latch(1);
+
+    // when:
+    Scheduler scheduler(SchedulerBackend::TimingWheel, milliseconds(1));
+    scheduler.Schedule(baseTime + milliseconds(after), [&]() {
+        auto now = system_clock::now();
+        auto diff = duration_cast<milliseconds>(now - baseTime);
+        // then:
+        int error = after * kScheduleErrorRatio;
+        EXPECT_NEAR(after, diff.count(), error);
+        latch.CountDown();
+    });
+    latch.Await();
+}
+
+TEST(Scheduler, SchedulePeriodically_TimingWheel) {
+    // setup:
+    const int repeatCount = 9;
+    std::atomic<int> count(0);
+    CountdownLatch latch(repeatCount + 1);
+
+    // when:
+    Scheduler scheduler(SchedulerBackend::TimingWheel, milliseconds(2));
+    scheduler.Schedule(system_clock::now(), milliseconds(5), repeatCount, [&]() {
+        count++;
+        latch.CountDown();
+    });
+    latch.Await();
+
+    // then:
+    EXPECT_EQ(repeatCount + 1, count);
+}
+
+TEST(TimingWheel, PopExpired_AcrossLevels) {
+    // setup: deadlines spread over several levels of the wheel
+    const int64_t tick = 3;
+    const int64_t start = 1000;
+    std::vector<int64_t> deadlines;
+    for (int64_t delay = 0; delay < 20000000; delay = delay * 3 + 7) {
+        deadlines.push_back(start + delay);
+        deadlines.push_back(start + delay + 1);
+    }
+
+    // when:
+    timingWheel wheel(tick, start);
+    for (int64_t deadline : deadlines) {
+        wheel.Push(scheduledTask{nullptr, deadline, 0, 0}, start);
+    }
+    std::vector<int64_t> fired;
+    int64_t now = start;
+    while (!wheel.Empty()) {
+        now = std::max(now, wheel.NextTime());
+        std::vector<scheduledTask> expired;
+        wheel.PopExpired(now, &expired);
+        for (auto& task : expired) {
+            // then: never early, and late by less than a tick
+            EXPECT_LE(task.execTime, now);
+            EXPECT_GT(task.execTime + tick, now);
+            fired.push_back(task.execTime);
+        }
+    }
+
+    // then:
+    std::sort(deadlines.begin(), deadlines.end());
+    EXPECT_EQ(deadlines, fired);
+}
+
+TEST(TimingWheel, Push_BeyondWheel) {
+    // setup:
+    const int64_t deadline = int64_t(1) << 40;
+
+    // when:
+    timingWheel wheel(1, 0);
+    wheel.Push(scheduledTask{nullptr, deadline, 0, 0}, 0);
+    std::vector<scheduledTask> expired;
+    int64_t now = 0;
+    while (expired.empty()) {
+        now = wheel.NextTime();
+        wheel.PopExpired(now, &expired);
+    }
+
+    // then:
+    EXPECT_EQ(deadline, now);
+}
+
+TEST(TimingWheel, Cancel) {
+    // when:
+    timingWheel wheel(1, 0);
+    uint64_t first = wheel.Push(scheduledTask{nullptr, 10, 0, 0}, 0);
+    wheel.Push(scheduledTask{nullptr, 5000, 0, 0}, 0);
+    bool result = wheel.Cancel(first);
+
+    // then:
+    EXPECT_TRUE(result);
+    EXPECT_FALSE(wheel.Cancel(first));
+    EXPECT_FALSE(wheel.Empty());
+    EXPECT_LT(10, wheel.NextTime());
+
+    // when: the node of the cancelled task is reused
+    uint64_t reused = wheel.Push(scheduledTask{nullptr, 20, 0, 0}, 0);
+
+    // then:
+    EXPECT_FALSE(wheel.Cancel(first));
+    EXPECT_TRUE(wheel.Cancel(reused));
+}
+
+TEST(TimerHeap, Cancel_Compacts) {
+    // setup:
+    const int count = 1000;
+    const int kept = 500;
+    std::vector<uint64_t> ids;
+
+    // when:
+    timerHeap heap;
+    for (int i = 0; i < count; i++) {
+        ids.push_back(heap.Push(scheduledTask{nullptr, i, 0, 0}, 0));
+    }
+    for (int i = 0; i < count; i++) {
+        if (i != kept) {
+            EXPECT_TRUE(heap.Cancel(ids[i]));
+        }
+    }
+    std::vector<scheduledTask> expired;
+    heap.PopExpired(count, &expired);
+
+    // then:
+    EXPECT_FALSE(heap.Cancel(ids[0]));
+    ASSERT_EQ(1, expired.size());
+    EXPECT_EQ(kept, expired[0].execTime);
+    EXPECT_TRUE(heap.Empty());
+    EXPECT_FALSE(heap.Cancel(ids[kept]));
+}
+
+namespace {
+
+// Pops a task with period 10 that is 35 late, i.e. has missed three runs,
+// and returns how many times it runs in total.
+int runsOfLateTask(timerQueue& queue, MissedRunPolicy policy, int16_t repeatCount) {
+    queue.SetMissedRunPolicy(policy);
+    queue.Push(scheduledTask{nullptr, 0, 10, repeatCount}, 0);
+    std::vector<scheduledTask> expired;
+    queue.PopExpired(35, &expired);
+    while (!queue.Empty()) {
+        queue.PopExpired(queue.NextTime(), &expired);
+    }
+    return static_cast<int>(expired.size());
+}
+
+} // namespace
+
+TEST(TimerQueue, PopExpired_MissedRunPolicy) {
+    for (int backend = 0; backend < 2; backend++) {
+        auto makeQueue = [backend]() -> std::unique_ptr<timerQueue> {
+            if (backend == 0) {
+                return std::unique_ptr<timerQueue>(new timerHeap());
+            }
+            return std::unique_ptr<timerQueue>(new timingWheel(1, 0));
+        };
+
+        // then: runs at 0, 10, 20, 30, 40, 50
+        EXPECT_EQ(6, runsOfLateTask(*makeQueue(), MissedRunPolicy::CatchUp, 5));
+        // then: runs once for 0 to 30, then at 40, 50
+        EXPECT_EQ(3, runsOfLateTask(*makeQueue(), MissedRunPolicy::Coalesce, 5));
+        // then: runs once for 30, then at 40, 50, 60, 70, 80
+        EXPECT_EQ(6, runsOfLateTask(*makeQueue(), MissedRunPolicy::Skip, 5));
+        // then: runs once, as the last run was already due
+        EXPECT_EQ(1, runsOfLateTask(*makeQueue(), MissedRunPolicy::Coalesce, 2));
+        // then: runs once for 30, then at 40, 50
+        EXPECT_EQ(3, runsOfLateTask(*makeQueue(), MissedRunPolicy::Skip, 2));
+    }
+}
+
+TEST(TimerQueue, PopExpired_SkipSlowTask) {
+    for (int backend = 0; backend < 2; backend++) {
+        // setup:
+        std::unique_ptr<timerQueue> queue(backend == 0
+                ? static_cast<timerQueue*>(new timerHeap()) : new timingWheel(1, 0));
+        queue->SetMissedRunPolicy(MissedRunPolicy::Skip);
+        queue->Push(scheduledTask{nullptr, 0, 10, -1}, 0);
+        std::vector<scheduledTask> expired;
+        int pops = 0;
+
+        // when: every run takes 2.5 periods, so the task is always late
+        for (int64_t now = 0; now < 250; pops++) {
+            now = std::max(now, queue->NextTime());
+            size_t before = expired.size();
+            queue->PopExpired(now, &expired);
+            if (expired.size() > before) {
+                now += 25;
+            }
+        }
+
+        // then: runs once whenever it is popped, at 0, 25, 50, ..., 225
+        EXPECT_EQ(10, pops);
+        EXPECT_EQ(10u, expired.size());
+    }
+}
@@ -0,0 +1,128 @@
+#include "ccl/task.h"
+#include <functional>
+#include <memory>
+#include <utility>
+#include <gtest/gtest.h>
+
+using namespace ccl;
+
+namespace {
+
+struct LargeFunc {
+    char padding[256];
+    int* called;
+
+    void operator()() {
+        (*called)++;
+    }
+};
+
+} // namespace
+
+TEST(Task, Empty) {
+    // when:
+    Task task;
+
+    // then:
+    EXPECT_FALSE(task);
+}
+
+TEST(Task, Empty_NullCallable) {
+    // setup:
+    std::function<void()> emptyFunction;
+    void (*nullPointer)() = nullptr;
+
+    // when:
+    Task fromFunction(emptyFunction);
+    Task fromPointer(nullPointer);
+
+    // then:
+    EXPECT_FALSE(fromFunction);
+    EXPECT_FALSE(fromPointer);
+}
+
+TEST(Task, Invoke_Inline) {
+    // setup:
+    int called = 0;
+
+    // when:
+    Task task([&]() { called++; });
+    task();
+    task();
+
+    // then:
+    EXPECT_TRUE(task);
+    EXPECT_EQ(2, called);
+}
+
+TEST(Task, Invoke_Heap) {
+    // setup:
+    int called = 0;
+
+    // when:
+    Task task(LargeFunc{{}, &called});
+    task();
+
+    // then:
+    EXPECT_EQ(1, called);
+}
+
+TEST(Task, Invoke_MoveOnly) {
+    // setup:
+    std::unique_ptr<int> value(new int(10));
+    int received = 0;
+    struct MoveOnly {
+        std::unique_ptr<int> value;
+        int* received;
+        void operator()() {
+            *received = *value;
+        }
+    };
+
+    // when:
+    Task task(MoveOnly{std::move(value), &received});
+    task();
+
+    // then:
+    EXPECT_EQ(10, received);
+}
+
+TEST(Task, Move) {
+    // setup:
+    int called = 0;
+    int largeCalled = 0;
+
+    // when:
+    Task task1([&]() { called++; });
+    Task task2(std::move(task1));
+    Task task3(LargeFunc{{}, &largeCalled});
+    task3 = std::move(task2);
+    task3();
+
+    // then:
+    EXPECT_FALSE(task1);
+    EXPECT_FALSE(task2);
+    EXPECT_TRUE(task3);
+    EXPECT_EQ(1, called);
+    EXPECT_EQ(0, largeCalled);
+}
+
+TEST(Task, Reset_DestroysCallable) {
+    // setup:
+    auto shared = std::make_shared<int>(0);
+
+    // when:
+    Task task([shared]() {});
+    EXPECT_EQ(2, shared.use_count());
+    task.reset();
+
+    // then:
+    EXPECT_FALSE(task);
+    EXPECT_EQ(1, shared.use_count());
+}
+
+TEST(Task, InlineSize) {
+    // then:
+    EXPECT_EQ(64, sizeof(Task));
+    EXPECT_EQ(136, sizeof(BasicTask<128>));
+}
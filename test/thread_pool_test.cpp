@@ -1,9 +1,13 @@
 #include "ccl/thread_pool.h"
 #include <atomic>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <thread>
+#include <vector>
 #include <gtest/gtest.h>
+#include "ccl/countdown_latch.h"
 #include "util.h"
 
 using namespace ccl;
@@ -35,6 +39,159 @@ TEST(ThreadPool, Dispatch) {
     EXPECT_EQ(dispatchCount, count);
 }
 
+TEST(ThreadPool, Dispatch_MoveOnlyTask) {
+    // setup:
+    struct MoveOnly {
+        std::unique_ptr<int> value;
+        int* received;
+        void operator()() {
+            *received = *value;
+        }
+    };
+    const int value = 10;
+    int received = 0;
+
+    // when:
+    {
+        ThreadPool pool(1);
+        pool.Dispatch(MoveOnly{std::unique_ptr<int>(new int(value)), &received});
+    }
+
+    // then:
+    EXPECT_EQ(value, received);
+}
+
+TEST(ThreadPool, Dispatch_EmptyTask) {
+    // setup:
+    std::function<void()> emptyFunction;
+    void (*nullPointer)() = nullptr;
+    CountdownLatch latch(1);
+
+    // when:
+    ThreadPool pool(1);
+    bool fromFunction = pool.Dispatch(emptyFunction);
+    bool fromPointer = pool.Dispatch(nullPointer);
+    pool.Dispatch([&]() {
+        latch.CountDown();
+    });
+
+    // then: rejected, and the worker is still alive
+    EXPECT_FALSE(fromFunction);
+    EXPECT_FALSE(fromPointer);
+    latch.Await();
+}
+
+TEST(ThreadPool, Dispatch_RingBufferQueue) {
+    // setup:
+    const int nthreads = 10;
+    const int dispatchCount = 1000;
+    std::atomic<int> count(0);
+
+    // when:
+    {
+        BasicThreadPool<RingBufferQueue<Task>> pool(nthreads, 64);
+        for (int i = 0; i < dispatchCount; i++) {
+            pool.Dispatch([&]() {
+                count++;
+            });
+        }
+    }
+
+    // then:
+    EXPECT_EQ(dispatchCount, count);
+}
+
+TEST(ThreadPool, Dispatch_Batch) {
+    // setup:
+    const int nthreads = 4;
+    const int dispatchCount = 1000;
+    std::atomic<int> count(0);
+
+    // when:
+    {
+        ThreadPool pool(nthreads);
+        pool.SetBatchSize(16);
+        for (int i = 0; i < dispatchCount; i++) {
+            pool.Dispatch([&]() {
+                count++;
+            });
+        }
+    }
+
+    // then:
+    EXPECT_EQ(dispatchCount, count);
+}
+
+TEST(ThreadPool, Dispatch_WorkStealing) {
+    // setup:
+    const int nthreads = 4;
+    const int dispatchCount = 1000;
+    std::atomic<int> count(0);
+
+    // when:
+    {
+        ThreadPool pool(nthreads, SIZE_MAX, DispatchMode::WorkStealing);
+        for (int i = 0; i < dispatchCount; i++) {
+            pool.Dispatch([&]() {
+                count++;
+            });
+        }
+    }
+
+    // then:
+    EXPECT_EQ(dispatchCount, count);
+}
+
+TEST(ThreadPool, Dispatch_WorkStealing_ForkJoin) {
+    // setup:
+    const int nthreads = 4;
+    const int depth = 10;
+    const int leafCount = 1 << depth;
+    std::atomic<int> count(0);
+    CountdownLatch latch(leafCount);
+
+    // when: each task forks two subtasks from inside the pool
+    ThreadPool pool(nthreads, SIZE_MAX, DispatchMode::WorkStealing);
+    std::function<void(int)> fork = [&](int level) {
+        if (level == depth) {
+            count++;
+            latch.CountDown();
+            return;
+        }
+        pool.Dispatch([&, level]() { fork(level + 1); });
+        pool.Dispatch([&, level]() { fork(level + 1); });
+    };
+    pool.Dispatch([&]() { fork(0); });
+    latch.Await();
+
+    // then:
+    EXPECT_EQ(leafCount, count);
+}
+
+TEST(ThreadPool, Dispatch_WorkStealing_LIFO) {
+    // setup:
+    std::vector<int> order;
+    CountdownLatch latch(1);
+
+    // when: a single worker runs the tasks it dispatched itself in LIFO order
+    {
+        ThreadPool pool(1, SIZE_MAX, DispatchMode::WorkStealing);
+        pool.Dispatch([&]() {
+            for (int i = 0; i < 3; i++) {
+                pool.Dispatch([&, i]() { order.push_back(i); });
+            }
+            latch.CountDown();
+        });
+        latch.Await();
+    }
+
+    // then:
+    ASSERT_EQ(3, order.size());
+    EXPECT_EQ(2, order[0]);
+    EXPECT_EQ(1, order[1]);
+    EXPECT_EQ(0, order[2]);
+}
+
 TEST(ThreadPool, ShutdownNow) {
     // setup:
     const int nthreads = 10;
@@ -56,3 +213,208 @@ TEST(ThreadPool, ShutdownNow) {
     // then:
     EXPECT_NE(dispatchCount, count);
 }
+
+TEST(ThreadPool, ShutdownNow_WorkStealing) {
+    // setup:
+    const int nthreads = 4;
+    const int dispatchCount = 1000;
+    std::atomic<int> count(0);
+
+    // when:
+    {
+        ThreadPool pool(nthreads, SIZE_MAX, DispatchMode::WorkStealing);
+        pool.SetShutdownNow(true);
+        for (int i = 0; i < dispatchCount; i++) {
+            pool.Dispatch([&]() {
+                util::DoHeavyTask();
+                count++;
+            });
+        }
+    }
+
+    // then:
+    EXPECT_NE(dispatchCount, count);
+}
+
+TEST(ThreadPool, Shutdown) {
+    // setup:
+    const int dispatchCount = 100;
+    std::atomic<int> count(0);
+
+    // when:
+    ThreadPool pool(4);
+    for (int i = 0; i < dispatchCount; i++) {
+        pool.Dispatch([&]() {
+            count++;
+        });
+    }
+    pool.Shutdown();
+    bool terminated = pool.AwaitTermination(std::chrono::seconds(10));
+
+    // then: the dispatched tasks were executed and new ones are rejected
+    EXPECT_TRUE(terminated);
+    EXPECT_TRUE(pool.IsShutdown());
+    EXPECT_TRUE(pool.IsTerminated());
+    EXPECT_EQ(dispatchCount, count);
+    EXPECT_FALSE(pool.Dispatch([&]() { count++; }));
+}
+
+TEST(ThreadPool, Shutdown_WorkStealing) {
+    // setup:
+    const int dispatchCount = 100;
+    std::atomic<int> count(0);
+
+    // when:
+    ThreadPool pool(4, SIZE_MAX, DispatchMode::WorkStealing);
+    for (int i = 0; i < dispatchCount; i++) {
+        pool.Dispatch([&]() {
+            count++;
+        });
+    }
+    pool.Shutdown();
+    bool terminated = pool.AwaitTermination(std::chrono::seconds(10));
+
+    // then:
+    EXPECT_TRUE(terminated);
+    EXPECT_EQ(dispatchCount, count);
+    EXPECT_FALSE(pool.Dispatch([&]() { count++; }));
+}
+
+TEST(ThreadPool, ShutdownNow_ReturnsQueuedTasks) {
+    // setup:
+    const int dispatchCount = 10;
+    CountdownLatch started(1);
+    CountdownLatch release(1);
+    std::atomic<int> count(0);
+
+    // when: the only worker is blocked while the other tasks are queued
+    ThreadPool pool(1);
+    pool.Dispatch([&]() {
+        started.CountDown();
+        release.Await();
+    });
+    started.Await();
+    for (int i = 0; i < dispatchCount; i++) {
+        pool.Dispatch([&]() {
+            count++;
+        });
+    }
+    std::vector<Task> tasks = pool.ShutdownNow();
+
+    // then: the pool does not terminate while the running task blocks
+    EXPECT_FALSE(pool.AwaitTermination(std::chrono::milliseconds(10)));
+    release.CountDown();
+    EXPECT_TRUE(pool.AwaitTermination(std::chrono::seconds(10)));
+    EXPECT_EQ(dispatchCount, tasks.size());
+    EXPECT_EQ(0, count);
+
+    // when: the returned tasks can be run by the caller
+    for (Task& task : tasks) {
+        task();
+    }
+
+    // then:
+    EXPECT_EQ(dispatchCount, count);
+}
+
+TEST(ThreadPool, ShutdownNow_WorkStealing_ReturnsQueuedTasks) {
+    // setup:
+    const int dispatchCount = 10;
+    CountdownLatch started(1);
+    CountdownLatch release(1);
+    std::atomic<int> count(0);
+
+    // when: the only worker queues tasks to its own deque and blocks
+    ThreadPool pool(1, SIZE_MAX, DispatchMode::WorkStealing);
+    pool.Dispatch([&]() {
+        for (int i = 0; i < dispatchCount; i++) {
+            pool.Dispatch([&]() {
+                count++;
+            });
+        }
+        started.CountDown();
+        release.Await();
+    });
+    started.Await();
+    std::vector<Task> tasks = pool.ShutdownNow();
+    release.CountDown();
+    pool.AwaitTermination();
+
+    // then:
+    EXPECT_EQ(dispatchCount, tasks.size());
+    EXPECT_EQ(0, count);
+}
+
+TEST(ThreadPool, Snapshot) {
+    // setup:
+    const int nthreads = 2;
+    const int dispatchCount = 100;
+    CountdownLatch started(1);
+    CountdownLatch release(1);
+    CountdownLatch done(dispatchCount);
+
+    // when: one worker blocks while the other runs the tasks
+    BasicThreadPool<BlockingQueue<Task>, ThreadPoolMetrics> pool(nthreads);
+    pool.Dispatch([&]() {
+        started.CountDown();
+        release.Await();
+    });
+    started.Await();
+    for (int i = 0; i < dispatchCount; i++) {
+        pool.Dispatch([&]() {
+            done.CountDown();
+        });
+    }
+    done.Await();
+    ThreadPoolStats running = pool.Snapshot();
+    release.CountDown();
+    pool.Shutdown();
+    pool.AwaitTermination();
+    ThreadPoolStats stats = pool.Snapshot();
+
+    // then:
+    EXPECT_EQ(dispatchCount + 1, running.dispatched);
+    EXPECT_EQ(0, running.queueDepth);
+    EXPECT_EQ(dispatchCount + 1, running.total.tasksStarted);
+
+    ASSERT_EQ(nthreads, stats.workers.size());
+    EXPECT_EQ(dispatchCount + 1, stats.total.tasksRun);
+    EXPECT_EQ(dispatchCount + 1, stats.total.runTime.Count());
+    EXPECT_LE(1u, stats.total.waitTime.Count()); // sampled
+    EXPECT_LT(0, stats.total.busyTime);
+    EXPECT_LE(0, stats.Utilization());
+    EXPECT_GE(1, stats.Utilization());
+}
+
+TEST(ThreadPool, Snapshot_WorkStealing) {
+    // setup:
+    const int dispatchCount = 100;
+    std::atomic<int> count(0);
+    CountdownLatch dispatched(1);
+
+    // when: the tasks are dispatched from a worker to its own deque
+    BasicThreadPool<BlockingQueue<Task>, ThreadPoolMetrics> pool(2, SIZE_MAX, DispatchMode::WorkStealing);
+    pool.Dispatch([&]() {
+        for (int i = 0; i < dispatchCount; i++) {
+            pool.Dispatch([&]() {
+                count++;
+            });
+        }
+        dispatched.CountDown();
+    });
+    dispatched.Await();
+    pool.Shutdown();
+    pool.AwaitTermination();
+    ThreadPoolStats stats = pool.Snapshot();
+
+    // then:
+    EXPECT_EQ(dispatchCount, count);
+    EXPECT_EQ(dispatchCount + 1, stats.dispatched);
+    EXPECT_EQ(0, stats.queueDepth);
+    EXPECT_EQ(dispatchCount + 1, stats.total.tasksRun);
+    uint64_t steals = 0;
+    for (auto& w : stats.workers) {
+        steals += w.steals;
+    }
+    EXPECT_EQ(steals, stats.total.steals);
+}
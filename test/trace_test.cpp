@@ -0,0 +1,164 @@
+#include "ccl/trace.h"
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace ccl;
+
+namespace {
+
+const TraceThread* findThread(const std::vector<TraceThread>& threads, const std::string& name) {
+    for (auto& thread : threads) {
+        if (thread.name == name) {
+            return &thread;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST(Tracer, Instant) {
+    // setup:
+    Tracer::Clear();
+
+    // when:
+    std::thread th([]() {
+        Tracer::SetThreadName("Instant");
+        Tracer::Instant("first", 1);
+        Tracer::Instant("second", 2);
+    });
+    th.join();
+    auto threads = Tracer::Collect();
+
+    // then:
+    const TraceThread* thread = findThread(threads, "Instant");
+    ASSERT_NE(nullptr, thread);
+    ASSERT_EQ(2, thread->events.size());
+    EXPECT_STREQ("first", thread->events[0].name);
+    EXPECT_EQ(1u, thread->events[0].arg);
+    EXPECT_EQ(int64_t(TraceEvent::kInstant), thread->events[0].duration);
+    EXPECT_STREQ("second", thread->events[1].name);
+    EXPECT_LE(thread->events[0].timestamp, thread->events[1].timestamp);
+}
+
+TEST(Tracer, TraceScope) {
+    // setup:
+    Tracer::Clear();
+
+    // when:
+    std::thread th([]() {
+        Tracer::SetThreadName("TraceScope");
+        TraceScope scope("scope");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+    th.join();
+    auto threads = Tracer::Collect();
+
+    // then:
+    const TraceThread* thread = findThread(threads, "TraceScope");
+    ASSERT_NE(nullptr, thread);
+    ASSERT_EQ(1, thread->events.size());
+    EXPECT_STREQ("scope", thread->events[0].name);
+    EXPECT_LE(1000000, thread->events[0].duration);
+}
+
+TEST(Tracer, Collect_Overwritten) {
+    // setup:
+    Tracer::Clear();
+    const size_t count = Tracer::kBufferCapacity + 10;
+
+    // when:
+    std::thread th([count]() {
+        Tracer::SetThreadName("Overwritten");
+        for (size_t i = 0; i < count; i++) {
+            Tracer::Instant("event", i);
+        }
+    });
+    th.join();
+    auto threads = Tracer::Collect();
+
+    // then: the oldest events are gone
+    const TraceThread* thread = findThread(threads, "Overwritten");
+    ASSERT_NE(nullptr, thread);
+    ASSERT_EQ(size_t(Tracer::kBufferCapacity), thread->events.size());
+    EXPECT_EQ(10u, thread->events.front().arg);
+    EXPECT_EQ(count - 1, thread->events.back().arg);
+}
+
+TEST(Tracer, Collect_WhileRecording) {
+    // setup:
+    Tracer::Clear();
+    std::atomic<bool> stopped(false);
+
+    // when:
+    std::thread th([&]() {
+        Tracer::SetThreadName("WhileRecording");
+        for (uint64_t i = 0; !stopped; i++) {
+            Tracer::Instant("event", i);
+        }
+    });
+    for (int i = 0; i < 10; i++) {
+        auto threads = Tracer::Collect();
+
+        // then: the events are in order without gaps
+        const TraceThread* thread = findThread(threads, "WhileRecording");
+        if (thread == nullptr) {
+            continue;
+        }
+        for (size_t j = 1; j < thread->events.size(); j++) {
+            ASSERT_EQ(thread->events[j - 1].arg + 1, thread->events[j].arg);
+        }
+    }
+
+    // cleanup:
+    stopped = true;
+    th.join();
+}
+
+TEST(Tracer, SetEnabled) {
+    // setup:
+    Tracer::Clear();
+
+    // when:
+    Tracer::SetEnabled(false);
+    std::thread th([]() {
+        Tracer::SetThreadName("SetEnabled");
+        Tracer::Instant("event");
+    });
+    th.join();
+    Tracer::SetEnabled(true);
+    auto threads = Tracer::Collect();
+
+    // then:
+    const TraceThread* thread = findThread(threads, "SetEnabled");
+    ASSERT_NE(nullptr, thread);
+    EXPECT_EQ(0, thread->events.size());
+}
+
+TEST(Tracer, WriteChromeTrace) {
+    // setup:
+    Tracer::Clear();
+
+    // when:
+    std::thread th([]() {
+        Tracer::SetThreadName("Chrome \"trace\"");
+        Tracer::Instant("instant", 7);
+        TraceScope scope("scope");
+    });
+    th.join();
+    std::ostringstream out;
+    Tracer::WriteChromeTrace(out);
+    std::string json = out.str();
+
+    // then:
+    EXPECT_EQ(0, json.find("{\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"name\":\"Chrome \\\"trace\\\"\"}"));
+    EXPECT_NE(std::string::npos, json.find("{\"name\":\"instant\",\"pid\":1,\"tid\":"));
+    EXPECT_NE(std::string::npos, json.find("\"ph\":\"i\",\"s\":\"t\",\"args\":{\"arg\":7}}"));
+    EXPECT_NE(std::string::npos, json.find("\"ph\":\"X\",\"dur\":"));
+}
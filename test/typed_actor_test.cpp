@@ -0,0 +1,201 @@
+#include "ccl/typed_actor.h"
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "ccl/countdown_latch.h"
+#include "util.h"
+
+using namespace ccl;
+
+namespace {
+
+struct Point {
+    int x;
+    int y;
+};
+
+struct Receiver {
+    int* ints;
+    std::string* strings;
+    Point* points;
+
+    void operator()(int& msg) {
+        *ints += msg;
+    }
+    void operator()(std::string& msg) {
+        *strings += msg;
+    }
+    void operator()(Point& msg) {
+        *points = msg;
+    }
+};
+
+} // namespace
+
+TEST(TypedActor, Send) {
+    // setup:
+    int ints = 0;
+    std::string strings;
+    Point point{0, 0};
+
+    // when:
+    {
+        TypedActor<int, std::string, Point> actor(Receiver{&ints, &strings, &point});
+        actor.Send(1);
+        actor.Send(std::string("a"));
+        actor.Send(Point{2, 3});
+        actor.Send(4);
+        actor.Send(std::string("b")).get();
+    }
+
+    // then:
+    EXPECT_EQ(5, ints);
+    EXPECT_EQ("ab", strings);
+    EXPECT_EQ(2, point.x);
+    EXPECT_EQ(3, point.y);
+}
+
+TEST(TypedActor, Send_PropagatesException) {
+    // setup:
+    struct Thrower {
+        void operator()(int& msg) {
+            throw std::runtime_error("error");
+        }
+    };
+
+    // when:
+    TypedActor<int> actor(Thrower{});
+    auto future = actor.Send(0);
+
+    // then:
+    EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+TEST(TypedActor, Send_MoveSemantics) {
+    // setup:
+    util::CopyCounter received;
+    struct Mover {
+        util::CopyCounter* received;
+        void operator()(util::CopyCounter& msg) {
+            *received = std::move(msg);
+        }
+    };
+
+    // when:
+    {
+        TypedActor<util::CopyCounter> actor(Mover{&received});
+        actor.Send(util::CopyCounter{}).get();
+    }
+
+    // then:
+    EXPECT_EQ(0, received.CopyConstructorCount());
+    EXPECT_EQ(0, received.CopyAssignmentCount());
+}
+
+TEST(TypedActor, Tell_SharedPoolRunsMessagesSerially) {
+    // setup:
+    const int nactors = 100;
+    const int sendCount = 100;
+    std::atomic<int> overlaps(0);
+    std::vector<int> counts(nactors, 0);
+    std::vector<std::atomic<bool>> running(nactors);
+    for (auto& flag : running) {
+        flag = false;
+    }
+    struct Counter {
+        std::atomic<bool>* running;
+        int* count;
+        std::atomic<int>* overlaps;
+        void operator()(int& msg) {
+            if (running->exchange(true)) {
+                (*overlaps)++;
+            }
+            (*count)++; // not atomic: guarded by the actor's serial execution
+            *running = false;
+        }
+    };
+
+    // when:
+    auto pool = std::make_shared<ThreadPool>(4);
+    std::vector<std::unique_ptr<TypedActor<int>>> actors;
+    for (int i = 0; i < nactors; i++) {
+        actors.emplace_back(new TypedActor<int>(pool, Counter{&running[i], &counts[i], &overlaps}));
+        actors.back()->SetThroughput(8);
+    }
+    for (int j = 0; j < sendCount; j++) {
+        for (auto& actor : actors) {
+            actor->Tell(j);
+        }
+    }
+    actors.clear();
+    pool->Shutdown();
+    pool->AwaitTermination();
+
+    // then:
+    EXPECT_EQ(0, overlaps);
+    for (int count : counts) {
+        EXPECT_EQ(sendCount, count);
+    }
+}
+
+TEST(TypedActor, Tell_FromHandlerOnSharedPool) {
+    // setup:
+    const int sendCount = 10000;
+    std::atomic<int> received(0);
+    CountdownLatch latch(1);
+    struct Counter {
+        std::atomic<int>* received;
+        CountdownLatch* latch;
+        void operator()(int& msg) {
+            if (++*received == sendCount) {
+                latch->CountDown();
+            }
+        }
+    };
+    struct Forwarder {
+        TypedActor<int>* target;
+        void operator()(int& msg) {
+            for (int i = 0; i < msg; i++) {
+                target->Tell(i);
+            }
+        }
+    };
+
+    // when: a handler sends many messages while holding the only worker
+    auto pool = std::make_shared<ThreadPool>(1);
+    TypedActor<int> target(pool, Counter{&received, &latch});
+    TypedActor<int> forwarder(pool, Forwarder{&target});
+    forwarder.Tell(sendCount);
+
+    // then: the sends do not block
+    latch.Await();
+    EXPECT_EQ(sendCount, received);
+}
+
+TEST(TypedActor, ShutdownNow) {
+    // setup:
+    const int sendCount = 1000;
+    std::atomic<int> sum(0);
+    struct Adder {
+        std::atomic<int>* sum;
+        void operator()(int& msg) {
+            util::Delay();
+            *sum += msg;
+        }
+    };
+
+    // when:
+    {
+        TypedActor<int> actor(Adder{&sum});
+        for (int i = 0; i < sendCount; i++) {
+            actor.Tell(1);
+        }
+        actor.SetShutdownNow(true);
+    }
+
+    // then:
+    EXPECT_NE(sendCount, sum);
+}
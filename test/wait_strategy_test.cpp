@@ -0,0 +1,126 @@
+#include "ccl/wait_strategy.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <gtest/gtest.h>
+#include "util.h"
+
+using namespace ccl;
+using namespace std::chrono;
+
+namespace {
+
+// Sets a flag on another thread after a delay and waits for it with the strategy.
+template<typename WaitStrategy>
+void expectWaitReturnsOnNotify() {
+    // setup:
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool ready = false;
+
+    // when:
+    std::thread th([&]() {
+        util::Delay();
+        std::lock_guard<std::mutex> lock(mutex);
+        ready = true;
+        condition.notify_all();
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    WaitStrategy::Wait(lock, condition, [&]() { return ready; });
+
+    // then:
+    EXPECT_TRUE(ready);
+    EXPECT_TRUE(lock.owns_lock());
+
+    // cleanup:
+    lock.unlock();
+    th.join();
+}
+
+// Waits for an atomic flag, which the strategy may check without the lock.
+template<typename WaitStrategy>
+void expectWaitChecksProbeWithoutLock() {
+    // setup:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::atomic<bool> ready(false);
+    int lockedChecks = 0;
+
+    // when:
+    std::thread th([&]() {
+        util::Delay();
+        ready = true;
+        std::lock_guard<std::mutex> lock(mutex);
+        condition.notify_all();
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    WaitStrategy::Wait(lock, condition, [&]() {
+        lockedChecks++;
+        return ready.load();
+    }, [&]() {
+        return ready.load();
+    });
+
+    // then: the lock was taken to check only before and after spinning
+    EXPECT_TRUE(ready);
+    EXPECT_TRUE(lock.owns_lock());
+    EXPECT_GE(3, lockedChecks);
+
+    // cleanup:
+    lock.unlock();
+    th.join();
+}
+
+template<typename WaitStrategy>
+void expectWaitUntilTimesOut() {
+    // setup:
+    const auto timeout = milliseconds(10);
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    // when:
+    auto start = steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    bool result = WaitStrategy::WaitUntil(lock, condition, start + timeout, []() { return false; });
+
+    // then:
+    EXPECT_FALSE(result);
+    EXPECT_LE(timeout, steady_clock::now() - start);
+    EXPECT_TRUE(lock.owns_lock());
+}
+
+} // namespace
+
+TEST(BlockingWait, Wait) {
+    expectWaitReturnsOnNotify<BlockingWait>();
+}
+
+TEST(BlockingWait, WaitUntil_Timeout) {
+    expectWaitUntilTimesOut<BlockingWait>();
+}
+
+TEST(SpinThenParkWait, Wait) {
+    expectWaitReturnsOnNotify<SpinThenParkWait<>>();
+}
+
+TEST(SpinThenParkWait, Wait_Probe) {
+    expectWaitChecksProbeWithoutLock<SpinThenParkWait<>>();
+}
+
+TEST(SpinThenParkWait, WaitUntil_Timeout) {
+    expectWaitUntilTimesOut<SpinThenParkWait<>>();
+}
+
+TEST(BusySpinWait, Wait) {
+    expectWaitReturnsOnNotify<BusySpinWait>();
+}
+
+TEST(BusySpinWait, Wait_Probe) {
+    expectWaitChecksProbeWithoutLock<BusySpinWait>();
+}
+
+TEST(BusySpinWait, WaitUntil_Timeout) {
+    expectWaitUntilTimesOut<BusySpinWait>();
+}
@@ -0,0 +1,88 @@
+#include "ccl/work_stealing_deque.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace ccl;
+
+TEST(WorkStealingDeque, PushAndPop_LIFO) {
+    // setup:
+    int elements[] = {1, 2, 3};
+
+    // when:
+    WorkStealingDeque<int*> deque;
+    for (int& e : elements) {
+        deque.Push(&e);
+    }
+
+    // then:
+    int* popped;
+    EXPECT_EQ(3, deque.Size());
+    ASSERT_TRUE(deque.Pop(&popped));
+    EXPECT_EQ(3, *popped);
+    ASSERT_TRUE(deque.Pop(&popped));
+    EXPECT_EQ(2, *popped);
+    ASSERT_TRUE(deque.Pop(&popped));
+    EXPECT_EQ(1, *popped);
+    EXPECT_FALSE(deque.Pop(&popped));
+    EXPECT_TRUE(deque.Empty());
+}
+
+TEST(WorkStealingDeque, PushAndSteal_FIFO) {
+    // setup:
+    int elements[] = {1, 2, 3};
+
+    // when:
+    WorkStealingDeque<int*> deque;
+    for (int& e : elements) {
+        deque.Push(&e);
+    }
+
+    // then:
+    int* stolen;
+    ASSERT_TRUE(deque.Steal(&stolen));
+    EXPECT_EQ(1, *stolen);
+    ASSERT_TRUE(deque.Steal(&stolen));
+    EXPECT_EQ(2, *stolen);
+    ASSERT_TRUE(deque.Steal(&stolen));
+    EXPECT_EQ(3, *stolen);
+    EXPECT_FALSE(deque.Steal(&stolen));
+}
+
+TEST(WorkStealingDeque, PopAndSteal_Concurrently) {
+    // setup:
+    const int pushCount = 100000;
+    const int nthieves = 3;
+    std::vector<int> elements(pushCount, 1);
+    std::atomic<int> sum(0);
+    std::atomic<bool> done(false);
+
+    // when: the owner pushes more elements than the initial capacity while thieves steal
+    WorkStealingDeque<int*> deque;
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < nthieves; i++) {
+        thieves.emplace_back([&]() {
+            int* stolen;
+            while (!done || !deque.Empty()) {
+                if (deque.Steal(&stolen)) {
+                    sum += *stolen;
+                }
+            }
+        });
+    }
+    int* popped;
+    for (int i = 0; i < pushCount; i++) {
+        deque.Push(&elements[i]);
+        if (i % 3 == 0 && deque.Pop(&popped)) {
+            sum += *popped;
+        }
+    }
+    done = true;
+    for (auto& th : thieves) {
+        th.join();
+    }
+
+    // then: every element was taken exactly once
+    EXPECT_EQ(pushCount, sum);
+}